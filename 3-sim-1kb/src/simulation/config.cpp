@@ -23,7 +23,8 @@ JSONCONS_N_MEMBER_TRAITS(
     logging_interval,
     sampling_interval,
     random_seed,
-    output_filename
+    output_filename,
+    profile_filename
 )
 
 
@@ -21,6 +21,7 @@ struct sampling_config
     md::step      sampling_interval    = 1;
     std::uint64_t random_seed          = 0;
     std::string   output_filename;
+    std::string   profile_filename;
 };
 
 
@@ -27,6 +27,7 @@ struct program_options
     program_mode                 mode;
     std::string                  config_filename;
     std::optional<std::string>   output_filename;
+    std::optional<std::string>   profile_filename;
     std::optional<std::string>   chains_filename;
     std::optional<std::uint64_t> random_seed;
 };
@@ -67,13 +68,14 @@ void show_usage()
 {
     std::cerr <<
         "Loop formation simulator\n"
-        "usage: main [-hCos] <config>\n"
+        "usage: main [-hCops] <config>\n"
         "\n"
         "  <config>     JSON file specifying simulation parameters\n"
         "\n"
         "options:\n"
         "  -C <config>  override chain definitions (config 'chains' key) by additional JSON file\n"
         "  -o <output>  override output HDF5 filename (config 'output_filename' key)\n"
+        "  -p <profile> save per-forcefield timings to JSON or CSV file (config 'profile_filename' key)\n"
         "  -s <seed>    override random seed (config 'random_seed' key)\n"
         "  -h           print this usage message and exit\n"
         "\n";
@@ -90,7 +92,7 @@ program_options parse_options(int argc, char** argv)
 
     cxx::getopt getopt;
 
-    for (int opt; (opt = getopt(argc, argv, "C:o:s:h")) != -1; ) {
+    for (int opt; (opt = getopt(argc, argv, "C:o:p:s:h")) != -1; ) {
         switch (opt) {
         case 'C':
             options.chains_filename = getopt.optarg;
@@ -100,6 +102,10 @@ program_options parse_options(int argc, char** argv)
             options.output_filename = getopt.optarg;
             break;
 
+        case 'p':
+            options.profile_filename = getopt.optarg;
+            break;
+
         case 's':
             options.random_seed = std::stoull(getopt.optarg);
             break;
@@ -142,6 +148,10 @@ simulation_config make_config(program_options const& options)
         config.sampling.output_filename = *options.output_filename;
     }
 
+    if (options.profile_filename) {
+        config.sampling.profile_filename = *options.profile_filename;
+    }
+
     if (options.random_seed) {
         config.sampling.random_seed = *options.random_seed;
     }
@@ -0,0 +1,135 @@
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+#include <md.hpp>
+
+#include "profiler.hpp"
+
+
+struct profile_section_record
+{
+    std::string name;
+    md::step    calls   = 0;
+    double      seconds = 0;
+};
+
+
+struct profile_counter_record
+{
+    std::string name;
+    md::step    value = 0;
+};
+
+
+struct profile_record
+{
+    std::vector<profile_section_record> sections;
+    std::vector<profile_counter_record> counters;
+};
+
+
+JSONCONS_ALL_MEMBER_TRAITS(profile_section_record, name, calls, seconds)
+JSONCONS_ALL_MEMBER_TRAITS(profile_counter_record, name, value)
+JSONCONS_ALL_MEMBER_TRAITS(profile_record, sections, counters)
+
+
+static double
+to_seconds(profiler::clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+
+md::index
+profiler::section(std::string const& name)
+{
+    for (md::index i = 0; i < _sections.size(); i++) {
+        if (_sections[i].name == name) {
+            return i;
+        }
+    }
+    _sections.push_back({.name = name});
+    return _sections.size() - 1;
+}
+
+
+void
+profiler::record(md::index section, clock::duration elapsed)
+{
+    auto& stats = _sections[section];
+    stats.calls++;
+    stats.time += elapsed;
+}
+
+
+void
+profiler::count(std::string const& name, md::step n)
+{
+    for (auto& [counter_name, value] : _counters) {
+        if (counter_name == name) {
+            value += n;
+            return;
+        }
+    }
+    _counters.emplace_back(name, n);
+}
+
+
+std::string
+profiler::format_json() const
+{
+    profile_record record;
+
+    for (auto const& stats : _sections) {
+        record.sections.push_back({
+            .name    = stats.name,
+            .calls   = stats.calls,
+            .seconds = to_seconds(stats.time),
+        });
+    }
+
+    for (auto const& [name, value] : _counters) {
+        record.counters.push_back({.name = name, .value = value});
+    }
+
+    std::string text;
+    jsoncons::encode_json(record, text);
+    return text;
+}
+
+
+std::string
+profiler::format_csv() const
+{
+    std::ostringstream csv;
+
+    csv << "kind,name,calls,seconds\n";
+    for (auto const& stats : _sections) {
+        csv << "section," << stats.name << ',' << stats.calls << ',' << to_seconds(stats.time) << '\n';
+    }
+    for (auto const& [name, value] : _counters) {
+        csv << "counter," << name << ',' << value << ",\n";
+    }
+
+    return csv.str();
+}
+
+
+void
+profiler::save(std::string const& filename) const
+{
+    auto const is_csv =
+        filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+
+    std::ofstream file{filename};
+    file << (is_csv ? format_csv() : format_json());
+
+    if (!file.flush()) {
+        throw std::runtime_error{"failed to write profile file"};
+    }
+}
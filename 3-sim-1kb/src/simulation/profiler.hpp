@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+
+/**
+ * Accumulates wall-clock time and call counts of named sections and values of
+ * named counters. Items are reported in the order of creation.
+ */
+class profiler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /** Returns the index of the named section, creating it if not exist. */
+    md::index section(std::string const& name);
+
+    /** Adds elapsed time to a section and increments its call count. */
+    void record(md::index section, clock::duration elapsed);
+
+    /** Adds n to the named counter, creating it if not exist. */
+    void count(std::string const& name, md::step n = 1);
+
+    /** Formats the profile as a JSON object string. */
+    std::string format_json() const;
+
+    /** Formats the profile as CSV text with columns kind, name, calls and seconds. */
+    std::string format_csv() const;
+
+    /** Saves the profile to a file. CSV if the filename ends with .csv, JSON otherwise. */
+    void save(std::string const& filename) const;
+
+private:
+    struct section_stats
+    {
+        std::string     name;
+        md::step        calls = 0;
+        clock::duration time  = {};
+    };
+
+    std::vector<section_stats>                    _sections;
+    std::vector<std::pair<std::string, md::step>> _counters;
+};
+
+
+/**
+ * Records the time between construction and destruction to a section of a
+ * profiler. Does nothing if the profiler is null.
+ */
+class profiler_scope
+{
+public:
+    profiler_scope(profiler* prof, md::index section)
+        : _profiler{prof}
+        , _section{section}
+    {
+        if (_profiler) {
+            _start = profiler::clock::now();
+        }
+    }
+
+    profiler_scope(profiler* prof, std::string const& section)
+        : profiler_scope{prof, prof ? prof->section(section) : 0}
+    {
+    }
+
+    ~profiler_scope()
+    {
+        if (_profiler) {
+            _profiler->record(_section, profiler::clock::now() - _start);
+        }
+    }
+
+    profiler_scope(profiler_scope const&) = delete;
+    profiler_scope& operator=(profiler_scope const&) = delete;
+
+private:
+    profiler*                   _profiler;
+    md::index                   _section;
+    profiler::clock::time_point _start;
+};
+
+
+/**
+ * Forcefield delegating to another forcefield and recording the time spent in
+ * compute_force and compute_energy to sections "<name>/force" and
+ * "<name>/energy".
+ */
+template<typename FF>
+class profiled_forcefield : public md::forcefield
+{
+public:
+    profiled_forcefield(
+        std::shared_ptr<profiler> prof, std::string const& name, std::shared_ptr<FF> inner
+    )
+        : _profiler{std::move(prof)}
+        , _forcefield{std::move(inner)}
+        , _force_section{_profiler->section(name + "/force")}
+        , _energy_section{_profiler->section(name + "/energy")}
+    {
+    }
+
+    md::scalar
+    compute_energy(md::system const& system) override
+    {
+        profiler_scope scope{_profiler.get(), _energy_section};
+        return _forcefield->compute_energy(system);
+    }
+
+    void
+    compute_force(md::system const& system, md::array_view<md::vector> forces) override
+    {
+        profiler_scope scope{_profiler.get(), _force_section};
+        _forcefield->compute_force(system, forces);
+    }
+
+private:
+    std::shared_ptr<profiler> _profiler;
+    std::shared_ptr<FF>       _forcefield;
+    md::index                 _force_section;
+    md::index                 _energy_section;
+};
+
+
+/**
+ * Adds a forcefield to system and returns a pointer to it. The forcefield is
+ * measured under given name if prof is not null.
+ */
+template<typename FF>
+std::shared_ptr<FF>
+add_profiled_forcefield(
+    md::system&                      system,
+    std::shared_ptr<profiler> const& prof,
+    std::string const&               name,
+    FF const&                        forcefield
+)
+{
+    auto const ptr = std::make_shared<FF>(forcefield);
+    if (prof) {
+        system.add_forcefield(std::make_shared<profiled_forcefield<FF>>(prof, name, ptr));
+    } else {
+        system.add_forcefield(ptr);
+    }
+    return ptr;
+}
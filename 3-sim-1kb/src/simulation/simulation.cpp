@@ -12,6 +12,7 @@
 #include "glues.hpp"
 #include "inits.hpp"
 #include "loops.hpp"
+#include "profiler.hpp"
 #include "simulation.hpp"
 #include "topology.hpp"
 #include "forces/glue_forcefield.hpp"
@@ -39,6 +40,10 @@ simulation::simulation(simulation_config const& config)
     , _random{make_random(config.sampling.random_seed)}
     , _store{config.sampling.output_filename}
 {
+    if (!_config.sampling.profile_filename.empty()) {
+        _profiler = std::make_shared<profiler>();
+    }
+
     setup_particles();
     setup_loops();
     setup_glues();
@@ -113,7 +118,10 @@ simulation::setup_forcefield_repulsion()
     auto const max_diameter = std::max(repulsive_potential.diameter, attractive_potential.diameter);
     auto const box_size = _config.chain.box_size;
 
-    _system.add_forcefield(
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "repulsion",
         md::make_neighbor_pairwise_forcefield<md::periodic_box>(interaction)
         .set_unit_cell({
             .x_period = box_size,
@@ -133,7 +141,10 @@ simulation::setup_forcefield_connectivity()
         .equilibrium_distance = _config.chain.bond_length,
     };
 
-    auto bonds = _system.add_forcefield(
+    auto bonds = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "bond",
         md::make_bonded_pairwise_forcefield(potential)
     );
 
@@ -151,7 +162,12 @@ simulation::setup_forcefield_bending()
         return md::cosine_bending_potential{data[i].bending_energy};
     };
 
-    auto bends = _system.add_forcefield(md::make_bonded_triplewise_forcefield(potential));
+    auto bends = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "bending",
+        md::make_bonded_triplewise_forcefield(potential)
+    );
 
     for (auto const& chain : _chains) {
         bends->add_bonded_range(chain.start, chain.end);
@@ -162,7 +178,10 @@ simulation::setup_forcefield_bending()
 void
 simulation::setup_forcefield_loop()
 {
-    _system.add_forcefield(
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "loop",
         loop_forcefield{_loops, _config.loop.bond_spring, _config.chain.repulsive_diameter}
     );
 }
@@ -173,7 +192,10 @@ simulation::setup_forcefield_glue()
 {
     auto const box_size = _config.chain.box_size;
 
-    _system.add_forcefield(
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "glue",
         glue_forcefield{
             _glues,
             {.x_period = box_size, .y_period = box_size, .z_period = box_size},
@@ -187,9 +209,13 @@ simulation::setup_forcefield_glue()
 void
 simulation::run()
 {
-    initialize_particles();
-    initialize_loops();
-    run_simulation();
+    {
+        profiler_scope scope{_profiler.get(), "run"};
+        initialize_particles();
+        initialize_loops();
+        run_simulation();
+    }
+    save_profile();
 }
 
 
@@ -245,6 +271,8 @@ simulation::run_simulation()
 void
 simulation::step_loops(md::step step)
 {
+    profiler_scope scope{_profiler.get(), "loop_update"};
+
     auto const leap_time =
         _config.sampling.timestep * md::scalar(_config.sampling.loop_update_interval);
 
@@ -261,6 +289,8 @@ simulation::step_loops(md::step step)
 void
 simulation::step_glues(md::step step)
 {
+    profiler_scope scope{_profiler.get(), "glue_update"};
+
     auto const leap_time =
         _config.sampling.timestep * md::scalar(_config.sampling.glue_update_interval);
 
@@ -298,8 +328,22 @@ simulation::show_progress(md::step step)
 void
 simulation::save_sample()
 {
+    profiler_scope scope{_profiler.get(), "store"};
+
     _store.save_snapshot({
         .positions = _system.view_positions(),
         .loops     = md::array_view<loop_pair const>{_loops->begin(), _loops->size()},
     });
 }
+
+
+void
+simulation::save_profile()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    _profiler->save(_config.sampling.profile_filename);
+    _store.save_profile(_profiler->format_json());
+}
@@ -8,6 +8,7 @@
 #include "config.hpp"
 #include "glues.hpp"
 #include "loops.hpp"
+#include "profiler.hpp"
 #include "store.hpp"
 #include "topology.hpp"
 
@@ -34,6 +35,7 @@ private:
     void step_glues(md::step step);
     void show_progress(md::step step);
     void save_sample();
+    void save_profile();
 
 private:
     simulation_config               _config;
@@ -43,4 +45,5 @@ private:
     std::shared_ptr<glue_simulator> _glues;
     std::mt19937_64                 _random;
     simulation_store                _store;
+    std::shared_ptr<profiler>       _profiler;
 };
@@ -56,3 +56,10 @@ simulation_store::save_snapshot(snapshot_record const& snapshot)
         _loops_stream->write(snapshot.loops);
     }
 }
+
+
+void
+simulation_store::save_profile(std::string const& profile)
+{
+    _file.dataset<h5::str>("profile").write(profile);
+}
@@ -30,6 +30,7 @@ public:
     explicit simulation_store(std::string const& filename);
     void     save_metadata(metadata_record const& metadata);
     void     save_snapshot(snapshot_record const& snapshot);
+    void     save_profile(std::string const& profile);
 
 private:
     h5::file                                     _file;
@@ -21,14 +21,16 @@ namespace
 
 char const program_usage[] = R"(
 usage:
-  simulation [-s <seed>] <config> <out>
+  simulation [-s <seed>] [--isa=<isa>] [--profile=<file>] <config> <out>
 
-  <config>    input JSON configuration file
-  <out>       output HDF5 trajectory file
+  <config>           input JSON configuration file
+  <out>              output HDF5 trajectory file
 
 options:
-  -s <seed>   specify random seed
-  -h, --help  print this usage message
+  -s <seed>          specify random seed
+  --isa=<isa>        SIMD kernels: sse (default), avx2, avx512 or auto
+  --profile=<file>   save forcefield timings to JSON or CSV file
+  -h, --help         print this usage message
 )";
 
 
@@ -60,6 +62,14 @@ namespace
         }
         config.output = options.at("<out>").asString();
 
+        if (auto isa_option = options.at("--isa")) {
+            config.isa = isa_option.asString();
+        }
+
+        if (auto profile_option = options.at("--profile")) {
+            config.profile = profile_option.asString();
+        }
+
         return config;
     }
 }
@@ -3,13 +3,19 @@
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <stdexcept>
+#include <vector>
 
 #include <md.hpp>
 
+#include "mixed_softcore_potential.hpp"
+#include "profiler.hpp"
 #include "simulation_config.hpp"
 #include "simulation_data.hpp"
 #include "simulation_driver.hpp"
 #include "simulation_store.hpp"
+#include "soa_softcore_forcefield.hpp"
+#include "verlet_pairwise_forcefield.hpp"
 #include "walltime.hpp"
 
 
@@ -30,6 +36,10 @@ simulation_driver::simulation_driver(simulation_config const& config)
     , _store{config.output}
     , _random{config.seed}
 {
+    if (!_config.profile.empty()) {
+        _profiler = std::make_shared<profiler>();
+    }
+
     _store.save_config(_config);
     setup_particles();
     setup_forcefield();
@@ -104,30 +114,104 @@ void simulation_driver::setup_forcefield_repulsions()
         .diameter = _config.b_core_diameter,
     };
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield<md::periodic_box>(
-            [=](md::index i, md::index j) {
-                auto const data = _system.view(particle_data_attribute);
-                auto const a_factor = (data[i].a_factor + data[j].a_factor) / 2;
-                auto const b_factor = (data[i].b_factor + data[j].b_factor) / 2;
-                return a_factor * a_potential + b_factor * b_potential;
-            }
-        )
-        .set_unit_cell({
-            .x_period = _config.box_size,
-            .y_period = _config.box_size,
-            .z_period = _config.box_size,
-        })
-        .set_neighbor_distance(
-            std::max(a_potential.diameter, b_potential.diameter)
-        )
+    auto const potential = [=](md::index i, md::index j) {
+        auto const data = _system.view(particle_data_attribute);
+        auto const a_factor = (data[i].a_factor + data[j].a_factor) / 2;
+        auto const b_factor = (data[i].b_factor + data[j].b_factor) / 2;
+        return mix_softcore_potentials(a_factor, a_potential, b_factor, b_potential);
+    };
+
+    md::periodic_box const unit_cell {
+        .x_period = _config.box_size,
+        .y_period = _config.box_size,
+        .z_period = _config.box_size,
+    };
+
+    auto const neighbor_distance = std::max(a_potential.diameter, b_potential.diameter);
+
+    if (_config.repulsion_kernel == "simd") {
+        setup_forcefield_simd_repulsions(a_potential, b_potential, unit_cell, neighbor_distance);
+        return;
+    }
+
+    if (_config.repulsion_kernel != "scalar") {
+        throw std::runtime_error("unknown repulsion kernel: " + _config.repulsion_kernel);
+    }
+
+    if (_config.neighbor_skin > 0) {
+        auto repulsions = add_profiled_forcefield(
+            _system,
+            _profiler,
+            "repulsion",
+            make_verlet_pairwise_forcefield<md::periodic_box>(potential)
+            .set_unit_cell(unit_cell)
+            .set_neighbor_distance(neighbor_distance)
+            .set_verlet_skin(_config.neighbor_skin)
+        );
+        _neighbor_rebuild_count = [=] {
+            return repulsions->rebuild_count();
+        };
+        return;
+    }
+
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "repulsion",
+        md::make_neighbor_pairwise_forcefield<md::periodic_box>(potential)
+        .set_unit_cell(unit_cell)
+        .set_neighbor_distance(neighbor_distance)
+    );
+}
+
+
+void simulation_driver::setup_forcefield_simd_repulsions(
+    md::softcore_potential<2> const& a_potential,
+    md::softcore_potential<8> const& b_potential,
+    md::periodic_box const& unit_cell,
+    md::scalar neighbor_distance
+)
+{
+    // Same repulsion as the scalar one but evaluated by SIMD kernels on
+    // structure-of-arrays data. SSE is the default for reproducibility; wider
+    // instruction sets are opt-in (--isa) and may change the last bits.
+
+    std::vector<md::scalar> a_factors;
+    std::vector<md::scalar> b_factors;
+    for (auto const& data : _system.view(particle_data_attribute)) {
+        a_factors.push_back(data.a_factor);
+        b_factors.push_back(data.b_factor);
+    }
+
+    auto const level = parse_simd_level(_config.isa);
+    std::clog << "[sim] repulsion kernel: simd (" << format_simd_level(level) << ")\n";
+
+    auto repulsions = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "repulsion",
+        make_soa_softcore_forcefield<md::periodic_box>(a_potential, b_potential)
+        .set_unit_cell(unit_cell)
+        .set_neighbor_distance(neighbor_distance)
+        .set_verlet_skin(_config.neighbor_skin)
+        .set_factors(a_factors, b_factors)
+        .set_simd_level(level)
     );
+
+    if (_config.neighbor_skin > 0) {
+        _neighbor_rebuild_count = [=] {
+            return repulsions->rebuild_count();
+        };
+    }
 }
 
 
 void simulation_driver::setup_forcefield_bonds()
 {
-    auto bonds = _system.add_forcefield(
+    auto bonds = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "bond",
         md::make_bonded_pairwise_forcefield(
             md::harmonic_potential {
                 .spring_constant = _config.bond_spring,
@@ -143,8 +227,12 @@ void simulation_driver::setup_forcefield_bonds()
 
 void simulation_driver::run()
 {
-    run_initialization();
-    run_sampling();
+    {
+        profiler_scope scope{_profiler.get(), "run"};
+        run_initialization();
+        run_sampling();
+    }
+    save_profile();
 }
 
 
@@ -193,8 +281,16 @@ void simulation_driver::run_sampling()
             << step
             << '\t'
             << "E: "
-            << energy
-            << '\n';
+            << energy;
+
+        if (_neighbor_rebuild_count) {
+            std::clog
+                << '\t'
+                << "rebuilds: "
+                << _neighbor_rebuild_count();
+        }
+
+        std::clog << '\n';
     };
 
     auto const callback = [&](md::step step) {
@@ -202,6 +298,7 @@ void simulation_driver::run_sampling()
             log_progress(step);
         }
         if (step % _config.sampling_interval == 0) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_snapshot(step, _system.view_positions());
         }
     };
@@ -215,3 +312,18 @@ void simulation_driver::run_sampling()
         .callback    = callback,
     });
 }
+
+
+void simulation_driver::save_profile()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    if (_neighbor_rebuild_count) {
+        _profiler->set_count("neighbor_rebuilds", _neighbor_rebuild_count());
+    }
+
+    _profiler->save(_config.profile);
+    _store.save_profile(_profiler->format_json());
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include <md.hpp>
 
+#include "profiler.hpp"
 #include "simulation_config.hpp"
 #include "simulation_data.hpp"
 #include "simulation_store.hpp"
@@ -22,9 +26,16 @@ private:
     void setup_particles();
     void setup_forcefield();
     void setup_forcefield_repulsions();
+    void setup_forcefield_simd_repulsions(
+        md::softcore_potential<2> const& a_potential,
+        md::softcore_potential<8> const& b_potential,
+        md::periodic_box const& unit_cell,
+        md::scalar neighbor_distance
+    );
     void setup_forcefield_bonds();
     void run_initialization();
     void run_sampling();
+    void save_profile();
 
 private:
     simulation_config _config;
@@ -32,4 +43,10 @@ private:
     md::system _system;
     md::random_engine _random;
     std::vector<chain_data> _chains;
+
+    // Reports neighbor list rebuilds if the Verlet list is enabled.
+    std::function<md::step()> _neighbor_rebuild_count;
+
+    // Measures forcefields and store writes if a profile output is given.
+    std::shared_ptr<profiler> _profiler;
 };
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "mixed_softcore_potential.hpp"
+#include "simd_softcore_kernel.hpp"
+#include "verlet_pair_list.hpp"
+
+
+// Mixed A/B softcore repulsion computed by the SIMD pair kernels. Positions,
+// A/B factors and pair forces are kept in structure-of-arrays layout, and the
+// pairs come from a Verlet list. The potential of a pair is
+// `a * a_potential + b * b_potential` where a and b are the averages of the
+// A/B factors of the particles.
+template<typename Box, int AP, int AQ, int BP, int BQ>
+class soa_softcore_forcefield : public md::forcefield
+{
+public:
+    soa_softcore_forcefield(
+        md::softcore_potential<AP, AQ> const& a_potential,
+        md::softcore_potential<BP, BQ> const& b_potential
+    )
+        : _unit_potential{mix_softcore_potentials(1, a_potential, 1, b_potential)}
+    {
+    }
+
+    // Sets the periodic unit cell (or other box type) of the system.
+    soa_softcore_forcefield& set_unit_cell(Box const& box)
+    {
+        _pair_list.set_unit_cell(box);
+        set_periods(box);
+        return *this;
+    }
+
+    // Sets the cutoff distance of the potential.
+    soa_softcore_forcefield& set_neighbor_distance(md::scalar dcut)
+    {
+        _pair_list.set_neighbor_distance(dcut);
+        return *this;
+    }
+
+    // Sets the skin distance. Zero skin rebuilds the list in every step.
+    soa_softcore_forcefield& set_verlet_skin(md::scalar skin)
+    {
+        _pair_list.set_verlet_skin(skin);
+        return *this;
+    }
+
+    // Sets the A/B factors of the particles.
+    soa_softcore_forcefield& set_factors(
+        std::vector<md::scalar> a_factors, std::vector<md::scalar> b_factors
+    )
+    {
+        _a_factors = std::move(a_factors);
+        _b_factors = std::move(b_factors);
+        return *this;
+    }
+
+    // Sets the SIMD instruction set used. The CPU must support it.
+    soa_softcore_forcefield& set_simd_level(simd_level level)
+    {
+        _simd_level = level;
+        return *this;
+    }
+
+    // Returns the number of times the list has been rebuilt.
+    md::step rebuild_count() const
+    {
+        return _pair_list.rebuild_count();
+    }
+
+    md::scalar compute_energy(md::system const& system) override
+    {
+        load(system);
+        return compute_softcore_energy(_simd_level, pair_data(), _unit_potential);
+    }
+
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override
+    {
+        load(system);
+
+        auto const pair_count = _pair_i.size();
+        _pair_fx.resize(pair_count);
+        _pair_fy.resize(pair_count);
+        _pair_fz.resize(pair_count);
+
+        compute_softcore_forces(
+            _simd_level,
+            pair_data(),
+            _unit_potential,
+            _pair_fx.data(),
+            _pair_fy.data(),
+            _pair_fz.data()
+        );
+
+        // Scatter is serial since pairs share particles.
+        for (md::index k = 0; k < pair_count; k++) {
+            md::vector const force = {_pair_fx[k], _pair_fy[k], _pair_fz[k]};
+            forces[_pair_i[k]] += force;
+            forces[_pair_j[k]] -= force;
+        }
+    }
+
+private:
+    void set_periods(md::periodic_box const& box)
+    {
+        _x_period = box.x_period;
+        _y_period = box.y_period;
+        _z_period = box.z_period;
+    }
+
+    void set_periods(md::open_box const&)
+    {
+        _x_period = 0;
+        _y_period = 0;
+        _z_period = 0;
+    }
+
+    void load(md::system const& system)
+    {
+        auto const positions = system.view_positions();
+
+        if (_pair_list.update(positions)) {
+            _pair_i.clear();
+            _pair_j.clear();
+            for (auto const& [i, j] : _pair_list.pairs()) {
+                _pair_i.push_back(static_cast<std::uint32_t>(i));
+                _pair_j.push_back(static_cast<std::uint32_t>(j));
+            }
+        }
+
+        _x.resize(positions.size());
+        _y.resize(positions.size());
+        _z.resize(positions.size());
+
+        for (md::index i = 0; i < positions.size(); i++) {
+            _x[i] = positions[i].x;
+            _y[i] = positions[i].y;
+            _z[i] = positions[i].z;
+        }
+    }
+
+    soa_pair_data pair_data() const
+    {
+        return {
+            _x.data(),
+            _y.data(),
+            _z.data(),
+            _a_factors.data(),
+            _b_factors.data(),
+            _pair_i.data(),
+            _pair_j.data(),
+            _pair_i.size(),
+            _x_period,
+            _y_period,
+            _z_period,
+        };
+    }
+
+private:
+    mixed_softcore_potential<AP, AQ, BP, BQ> _unit_potential;
+    verlet_pair_list<Box>                    _pair_list;
+    simd_level                               _simd_level = simd_level::sse;
+    md::scalar                               _x_period = 0;
+    md::scalar                               _y_period = 0;
+    md::scalar                               _z_period = 0;
+    std::vector<md::scalar>                  _a_factors;
+    std::vector<md::scalar>                  _b_factors;
+    std::vector<md::scalar>                  _x;
+    std::vector<md::scalar>                  _y;
+    std::vector<md::scalar>                  _z;
+    std::vector<std::uint32_t>               _pair_i;
+    std::vector<std::uint32_t>               _pair_j;
+    std::vector<md::scalar>                  _pair_fx;
+    std::vector<md::scalar>                  _pair_fy;
+    std::vector<md::scalar>                  _pair_fz;
+};
+
+
+// Creates a soa_softcore_forcefield with given pure A and B potentials.
+template<typename Box = md::open_box, int AP, int AQ, int BP, int BQ>
+soa_softcore_forcefield<Box, AP, AQ, BP, BQ> make_soa_softcore_forcefield(
+    md::softcore_potential<AP, AQ> const& a_potential,
+    md::softcore_potential<BP, BQ> const& b_potential
+)
+{
+    return {a_potential, b_potential};
+}
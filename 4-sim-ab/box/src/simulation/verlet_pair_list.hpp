@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+
+namespace detail
+{
+    inline md::vector displacement(md::open_box const&, md::point p, md::point q)
+    {
+        return p - q;
+    }
+
+    template<typename Box>
+    md::vector displacement(Box const& box, md::point p, md::point q)
+    {
+        return box.shortest_displacement(p, q);
+    }
+}
+
+
+// Verlet list of neighbor pairs. Pairs are searched within the cutoff distance
+// plus a skin, and the list is reused until some particle moves more than half
+// the skin. The list may contain pairs farther than the cutoff distance.
+template<typename Box>
+class verlet_pair_list
+{
+public:
+    // Sets the periodic unit cell (or other box type) of the system.
+    void set_unit_cell(Box const& box)
+    {
+        _box = box;
+        _searcher.reset();
+        _reference_positions.clear();
+    }
+
+    // Sets the cutoff distance.
+    void set_neighbor_distance(md::scalar dcut)
+    {
+        _neighbor_distance = dcut;
+        _reference_positions.clear();
+    }
+
+    // Sets the skin distance. Zero skin rebuilds the list in every update.
+    void set_verlet_skin(md::scalar skin)
+    {
+        _verlet_skin = skin;
+        _reference_positions.clear();
+    }
+
+    // Returns the box set by set_unit_cell.
+    Box const& unit_cell() const
+    {
+        return _box;
+    }
+
+    // Returns the number of times the list has been rebuilt.
+    md::step rebuild_count() const
+    {
+        return _rebuild_count;
+    }
+
+    // Rebuilds the list if some particle has moved too far since the last
+    // rebuild. Returns true if the list is rebuilt.
+    bool update(md::array_view<md::point const> positions)
+    {
+        if (is_valid(positions)) {
+            return false;
+        }
+        rebuild(positions);
+        return true;
+    }
+
+    // Returns the pairs found in the last rebuild.
+    std::vector<std::pair<md::index, md::index>> const& pairs() const
+    {
+        return _pairs;
+    }
+
+private:
+    bool is_valid(md::array_view<md::point const> positions) const
+    {
+        if (_verlet_skin <= 0 || _reference_positions.size() != positions.size()) {
+            return false;
+        }
+
+        auto const max_displacement = _verlet_skin / 2;
+        auto const max_displacement2 = max_displacement * max_displacement;
+
+        for (md::index i = 0; i < positions.size(); i++) {
+            auto const r = detail::displacement(_box, positions[i], _reference_positions[i]);
+            if (r.squared_norm() > max_displacement2) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void rebuild(md::array_view<md::point const> positions)
+    {
+        auto const list_dcut = _neighbor_distance + _verlet_skin;
+
+        if (!_searcher || list_dcut != _searcher_dcut) {
+            _searcher.emplace(_box, list_dcut);
+            _searcher_dcut = list_dcut;
+        }
+
+        _pairs.clear();
+        _searcher->set_points(positions);
+        _searcher->search(std::back_inserter(_pairs));
+
+        _reference_positions.assign(positions.begin(), positions.end());
+        _rebuild_count++;
+    }
+
+private:
+    Box                                          _box;
+    md::scalar                                   _neighbor_distance = 0;
+    md::scalar                                   _verlet_skin = 0;
+    md::step                                     _rebuild_count = 0;
+    std::optional<md::neighbor_searcher<Box>>    _searcher;
+    md::scalar                                   _searcher_dcut = 0;
+    std::vector<std::pair<md::index, md::index>> _pairs;
+    std::vector<md::point>                       _reference_positions;
+};
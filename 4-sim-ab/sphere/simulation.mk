@@ -4,6 +4,8 @@ DBGFLAGS = \
   -g \
   -DNDEBUG
 
+# Baseline is SSE4 for reproducible results. Pair kernels are also compiled
+# for AVX2 and AVX-512 via target attributes and selected with --isa.
 OPTFLAGS = \
   -O2 \
   -march=x86-64 \
@@ -0,0 +1,59 @@
+#include <stdexcept>
+#include <string>
+
+#include "simd_softcore_kernel.hpp"
+
+
+simd_level detect_simd_level()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        return simd_level::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return simd_level::avx2;
+    }
+    return simd_level::sse;
+}
+
+
+std::string format_simd_level(simd_level level)
+{
+    switch (level) {
+    case simd_level::sse:
+        return "sse";
+    case simd_level::avx2:
+        return "avx2";
+    case simd_level::avx512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+
+simd_level parse_simd_level(std::string const& name)
+{
+    auto const supported = detect_simd_level();
+
+    if (name == "auto") {
+        return supported;
+    }
+
+    simd_level level;
+
+    if (name == "sse") {
+        level = simd_level::sse;
+    } else if (name == "avx2") {
+        level = simd_level::avx2;
+    } else if (name == "avx512") {
+        level = simd_level::avx512;
+    } else {
+        throw std::runtime_error("unknown instruction set: " + name);
+    }
+
+    if (level > supported) {
+        throw std::runtime_error("instruction set not supported by CPU: " + name);
+    }
+    return level;
+}
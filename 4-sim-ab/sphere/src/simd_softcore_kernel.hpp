@@ -0,0 +1,411 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <md.hpp>
+
+#include "mixed_softcore_potential.hpp"
+
+
+// SIMD instruction set used by the softcore pair kernels.
+enum class simd_level
+{
+    sse,
+    avx2,
+    avx512,
+};
+
+
+// Returns the widest SIMD level supported by the running CPU.
+simd_level detect_simd_level();
+
+
+// Returns the name of a SIMD level.
+std::string format_simd_level(simd_level level);
+
+
+// Parses a SIMD level name: "sse", "avx2", "avx512" or "auto". "auto" selects
+// the widest level supported by the running CPU. Throws if the name is unknown
+// or the level is not supported by the CPU.
+simd_level parse_simd_level(std::string const& name);
+
+
+// Particle pairs and particle data in structure-of-arrays layout. Weights are
+// the A/B factors of particles, which are averaged for a pair. Zero period
+// means that the axis is not periodic.
+struct soa_pair_data
+{
+    md::scalar const*    x;
+    md::scalar const*    y;
+    md::scalar const*    z;
+    md::scalar const*    a_weights;
+    md::scalar const*    b_weights;
+    std::uint32_t const* pair_i;
+    std::uint32_t const* pair_j;
+    md::index            pair_count;
+    md::scalar           x_period = 0;
+    md::scalar           y_period = 0;
+    md::scalar           z_period = 0;
+};
+
+
+// Wide vectors never cross non-inlined function boundaries here, so the ABI
+// note GCC emits for them is irrelevant.
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace detail
+{
+    // Vector types of W lanes. Specialized for each width since GCC ignores
+    // vector_size with a dependent size.
+    template<int W>
+    struct simd_types;
+
+    template<>
+    struct simd_types<1>
+    {
+        using vec = md::scalar __attribute__((vector_size(8)));
+        using mask = std::int64_t __attribute__((vector_size(8)));
+    };
+
+    template<>
+    struct simd_types<2>
+    {
+        using vec = md::scalar __attribute__((vector_size(16)));
+        using mask = std::int64_t __attribute__((vector_size(16)));
+    };
+
+    template<>
+    struct simd_types<4>
+    {
+        using vec = md::scalar __attribute__((vector_size(32)));
+        using mask = std::int64_t __attribute__((vector_size(32)));
+    };
+
+    template<>
+    struct simd_types<8>
+    {
+        using vec = md::scalar __attribute__((vector_size(64)));
+        using mask = std::int64_t __attribute__((vector_size(64)));
+    };
+
+    template<int W>
+    using simd_vec = typename simd_types<W>::vec;
+
+    template<int W>
+    using simd_mask = typename simd_types<W>::mask;
+
+    // Helpers are always inlined so that they are compiled for the target of
+    // the calling kernel instance.
+
+    // Zeroes out lanes where mask is false. Bitwise selection works the same
+    // on GCC and clang, unlike the vector conditional operator.
+    template<int W>
+    [[gnu::always_inline]]
+    inline simd_vec<W> select(simd_mask<W> mask, simd_vec<W> v)
+    {
+        return (simd_vec<W>) (mask & (simd_mask<W>) v);
+    }
+
+    // Rounds to the nearest integer for |v| < 2^51 under the default rounding
+    // mode. Used for the minimum image convention.
+    template<int W>
+    [[gnu::always_inline]]
+    inline simd_vec<W> round_nearest(simd_vec<W> v)
+    {
+        md::scalar const magic = 6755399441055744.0; // 1.5 * 2^52
+        return (v + magic) - magic;
+    }
+
+    template<int N, int W>
+    [[gnu::always_inline]]
+    inline simd_vec<W> vec_power(simd_vec<W> x)
+    {
+        if constexpr (N == 0) {
+            return x * 0 + 1;
+        } else if constexpr (N % 2 == 0) {
+            auto const half = vec_power<N / 2, W>(x);
+            return half * half;
+        } else {
+            return x * vec_power<N - 1, W>(x);
+        }
+    }
+
+    template<int W>
+    [[gnu::always_inline]]
+    inline void store(md::scalar* dest, simd_vec<W> v)
+    {
+        std::memcpy(dest, &v, sizeof v);
+    }
+
+    template<int W>
+    [[gnu::always_inline]]
+    inline bool any_nonzero(simd_vec<W> v)
+    {
+        for (int lane = 0; lane < W; lane++) {
+            if (v[lane] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Pair block of W lanes loaded from SoA arrays.
+    template<int W>
+    struct softcore_block
+    {
+        simd_vec<W> dx;
+        simd_vec<W> dy;
+        simd_vec<W> dz;
+        simd_vec<W> r2;
+        simd_vec<W> a;
+        simd_vec<W> b;
+    };
+
+    template<int W>
+    [[gnu::always_inline]]
+    inline softcore_block<W> load_softcore_block(soa_pair_data const& data, md::index start)
+    {
+        softcore_block<W> block;
+
+        for (int lane = 0; lane < W; lane++) {
+            auto const i = data.pair_i[start + md::index(lane)];
+            auto const j = data.pair_j[start + md::index(lane)];
+            block.dx[lane] = data.x[i] - data.x[j];
+            block.dy[lane] = data.y[i] - data.y[j];
+            block.dz[lane] = data.z[i] - data.z[j];
+            block.a[lane] = data.a_weights[i] + data.a_weights[j];
+            block.b[lane] = data.b_weights[i] + data.b_weights[j];
+        }
+        block.a *= 0.5;
+        block.b *= 0.5;
+
+        if (data.x_period > 0) {
+            block.dx -= data.x_period * round_nearest<W>(block.dx * (1 / data.x_period));
+        }
+        if (data.y_period > 0) {
+            block.dy -= data.y_period * round_nearest<W>(block.dy * (1 / data.y_period));
+        }
+        if (data.z_period > 0) {
+            block.dz -= data.z_period * round_nearest<W>(block.dz * (1 / data.z_period));
+        }
+        block.r2 = block.dx * block.dx + block.dy * block.dy + block.dz * block.dz;
+
+        return block;
+    }
+
+    template<int P, int Q, int W>
+    [[gnu::always_inline]]
+    inline simd_vec<W> softcore_energy_term(simd_vec<W> r2, md::scalar diameter)
+    {
+        auto const u2 = r2 * (1 / (diameter * diameter));
+        auto const g = 1 - vec_power<P / 2, W>(u2);
+        return select<W>(u2 < 1, vec_power<Q, W>(g));
+    }
+
+    template<int P, int Q, int W>
+    [[gnu::always_inline]]
+    inline simd_vec<W> softcore_force_term(simd_vec<W> r2, md::scalar diameter)
+    {
+        auto const k2 = 1 / (diameter * diameter);
+        auto const u2 = r2 * k2;
+        auto const g = 1 - vec_power<P / 2, W>(u2);
+        auto const coef = (P * Q) * k2 * vec_power<P / 2 - 1, W>(u2) * vec_power<Q - 1, W>(g);
+        return select<W>(u2 < 1, coef);
+    }
+
+    template<int W, int AP, int AQ, int BP, int BQ>
+    [[gnu::always_inline]]
+    inline md::scalar softcore_block_energy(
+        softcore_block<W> const& block, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit
+    )
+    {
+        simd_vec<W> energy = {};
+
+        // The zero-weight term is skipped if it is zero in all lanes.
+        if (any_nonzero<W>(block.a)) {
+            energy += (unit.a_energy * block.a) * softcore_energy_term<AP, AQ, W>(block.r2, unit.a_diameter);
+        }
+        if (any_nonzero<W>(block.b)) {
+            energy += (unit.b_energy * block.b) * softcore_energy_term<BP, BQ, W>(block.r2, unit.b_diameter);
+        }
+
+        md::scalar sum = 0;
+        for (int lane = 0; lane < W; lane++) {
+            sum += energy[lane];
+        }
+        return sum;
+    }
+
+    template<int W, int AP, int AQ, int BP, int BQ>
+    [[gnu::always_inline]]
+    inline simd_vec<W> softcore_block_force_coef(
+        softcore_block<W> const& block, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit
+    )
+    {
+        simd_vec<W> coef = {};
+
+        if (any_nonzero<W>(block.a)) {
+            coef += (unit.a_energy * block.a) * softcore_force_term<AP, AQ, W>(block.r2, unit.a_diameter);
+        }
+        if (any_nonzero<W>(block.b)) {
+            coef += (unit.b_energy * block.b) * softcore_force_term<BP, BQ, W>(block.r2, unit.b_diameter);
+        }
+        return coef;
+    }
+
+    template<int W, int AP, int AQ, int BP, int BQ>
+    [[gnu::always_inline]]
+    inline md::scalar softcore_energy_body(
+        soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit
+    )
+    {
+        md::scalar sum = 0;
+        md::index start = 0;
+
+        for (; start + W <= data.pair_count; start += W) {
+            sum += softcore_block_energy<W>(load_softcore_block<W>(data, start), unit);
+        }
+        for (; start < data.pair_count; start++) {
+            sum += softcore_block_energy<1>(load_softcore_block<1>(data, start), unit);
+        }
+        return sum;
+    }
+
+    // Computes the force on pair_i[k] from pair_j[k] into fx[k], fy[k], fz[k].
+    template<int W, int AP, int AQ, int BP, int BQ>
+    [[gnu::always_inline]]
+    inline void softcore_force_body(
+        soa_pair_data const& data,
+        mixed_softcore_potential<AP, AQ, BP, BQ> const& unit,
+        md::scalar* fx,
+        md::scalar* fy,
+        md::scalar* fz
+    )
+    {
+        md::index start = 0;
+
+        for (; start + W <= data.pair_count; start += W) {
+            auto const block = load_softcore_block<W>(data, start);
+            auto const coef = softcore_block_force_coef<W>(block, unit);
+            store<W>(fx + start, coef * block.dx);
+            store<W>(fy + start, coef * block.dy);
+            store<W>(fz + start, coef * block.dz);
+        }
+        for (; start < data.pair_count; start++) {
+            auto const block = load_softcore_block<1>(data, start);
+            auto const coef = softcore_block_force_coef<1>(block, unit);
+            store<1>(fx + start, coef * block.dx);
+            store<1>(fy + start, coef * block.dy);
+            store<1>(fz + start, coef * block.dz);
+        }
+    }
+
+    // Kernel instances. Targets other than the baseline are compiled for
+    // the wider instruction sets regardless of the command-line flags and
+    // only called if the CPU supports them.
+
+    template<int AP, int AQ, int BP, int BQ>
+    md::scalar softcore_energy_sse(soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit)
+    {
+        return softcore_energy_body<2>(data, unit);
+    }
+
+    template<int AP, int AQ, int BP, int BQ>
+    __attribute__((target("avx2,fma")))
+    md::scalar softcore_energy_avx2(soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit)
+    {
+        return softcore_energy_body<4>(data, unit);
+    }
+
+    template<int AP, int AQ, int BP, int BQ>
+    __attribute__((target("avx512f,avx512dq")))
+    md::scalar softcore_energy_avx512(soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit)
+    {
+        return softcore_energy_body<8>(data, unit);
+    }
+
+    template<int AP, int AQ, int BP, int BQ>
+    void softcore_force_sse(
+        soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit,
+        md::scalar* fx, md::scalar* fy, md::scalar* fz
+    )
+    {
+        softcore_force_body<2>(data, unit, fx, fy, fz);
+    }
+
+    template<int AP, int AQ, int BP, int BQ>
+    __attribute__((target("avx2,fma")))
+    void softcore_force_avx2(
+        soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit,
+        md::scalar* fx, md::scalar* fy, md::scalar* fz
+    )
+    {
+        softcore_force_body<4>(data, unit, fx, fy, fz);
+    }
+
+    template<int AP, int AQ, int BP, int BQ>
+    __attribute__((target("avx512f,avx512dq")))
+    void softcore_force_avx512(
+        soa_pair_data const& data, mixed_softcore_potential<AP, AQ, BP, BQ> const& unit,
+        md::scalar* fx, md::scalar* fy, md::scalar* fz
+    )
+    {
+        softcore_force_body<8>(data, unit, fx, fy, fz);
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic pop
+#endif
+
+
+// Computes the total energy of the softcore pairs. unit is the potential for
+// pure A-A and B-B pairs, i.e., the energies are the ones for unit weights.
+template<int AP, int AQ, int BP, int BQ>
+md::scalar compute_softcore_energy(
+    simd_level level,
+    soa_pair_data const& data,
+    mixed_softcore_potential<AP, AQ, BP, BQ> const& unit
+)
+{
+    switch (level) {
+    case simd_level::avx512:
+        return detail::softcore_energy_avx512(data, unit);
+    case simd_level::avx2:
+        return detail::softcore_energy_avx2(data, unit);
+    case simd_level::sse:
+        break;
+    }
+    return detail::softcore_energy_sse(data, unit);
+}
+
+
+// Computes the force on the first particle of each softcore pair. Force on
+// the k-th pair is stored in fx[k], fy[k] and fz[k].
+template<int AP, int AQ, int BP, int BQ>
+void compute_softcore_forces(
+    simd_level level,
+    soa_pair_data const& data,
+    mixed_softcore_potential<AP, AQ, BP, BQ> const& unit,
+    md::scalar* fx,
+    md::scalar* fy,
+    md::scalar* fz
+)
+{
+    switch (level) {
+    case simd_level::avx512:
+        detail::softcore_force_avx512(data, unit, fx, fy, fz);
+        return;
+    case simd_level::avx2:
+        detail::softcore_force_avx2(data, unit, fx, fy, fz);
+        return;
+    case simd_level::sse:
+        break;
+    }
+    detail::softcore_force_sse(data, unit, fx, fy, fz);
+}
@@ -8,33 +8,37 @@
 
 
 // Enumerate (de)serielizable parameters as X macros here.
-#define X_CONFIG_JSON_PARAMETERS                 \
-    X(md::scalar,    a_core_diameter,       0.30) \
-    X(md::scalar,    b_core_diameter,       0.24) \
-    X(md::scalar,    a_core_repulsion,      2.0 ) \
-    X(md::scalar,    b_core_repulsion,      2.0 ) \
-    X(md::scalar,    bond_spring,           70  ) \
-    X(md::scalar,    mobility,              1.0 ) \
-    X(md::scalar,    outer_wall_radius,     1.0 ) \
-    X(md::scalar,    outer_wall_multiplier, 1.0 ) \
-    X(md::scalar,    outer_wall_spring,     1.0 ) \
-    X(md::scalar,    inner_wall_radius,     0.0 ) \
-    X(md::scalar,    inner_wall_multiplier, 1.0 ) \
-    X(md::scalar,    inner_wall_spring,     1.0 ) \
-    X(md::scalar,    init_bond_length,      0.0 ) \
-    X(md::scalar,    temperature,           1.0 ) \
-    X(md::scalar,    timestep,              1e-5) \
-    X(md::step,      steps,                 1000) \
-    X(md::step,      logging_interval,      1000) \
-    X(md::step,      sampling_interval,     1000) \
-    X(std::string,   beads_filename,        ""  ) \
-    X(std::uint64_t, seed,                  0   )
+#define X_CONFIG_JSON_PARAMETERS                      \
+    X(md::scalar,    a_core_diameter,       0.30    ) \
+    X(md::scalar,    b_core_diameter,       0.24    ) \
+    X(md::scalar,    a_core_repulsion,      2.0     ) \
+    X(md::scalar,    b_core_repulsion,      2.0     ) \
+    X(md::scalar,    bond_spring,           70      ) \
+    X(md::scalar,    mobility,              1.0     ) \
+    X(md::scalar,    outer_wall_radius,     1.0     ) \
+    X(md::scalar,    outer_wall_multiplier, 1.0     ) \
+    X(md::scalar,    outer_wall_spring,     1.0     ) \
+    X(md::scalar,    inner_wall_radius,     0.0     ) \
+    X(md::scalar,    inner_wall_multiplier, 1.0     ) \
+    X(md::scalar,    inner_wall_spring,     1.0     ) \
+    X(md::scalar,    neighbor_skin,         0.0     ) \
+    X(std::string,   repulsion_kernel,      "scalar") \
+    X(md::scalar,    init_bond_length,      0.0     ) \
+    X(md::scalar,    temperature,           1.0     ) \
+    X(md::scalar,    timestep,              1e-5    ) \
+    X(md::step,      steps,                 1000    ) \
+    X(md::step,      logging_interval,      1000    ) \
+    X(md::step,      sampling_interval,     1000    ) \
+    X(std::string,   beads_filename,        ""      ) \
+    X(std::uint64_t, seed,                  0       )
 
 
 // Simple aggregate of simulation parameters.
 struct simulation_config
 {
     std::string output;
+    std::string profile;
+    std::string isa = "sse";
 
 #define X(T, var, init) T var = init;
     X_CONFIG_JSON_PARAMETERS
@@ -61,7 +65,8 @@ namespace detail
 void load_simulation_config(std::istream& in, simulation_config& config);
 
 
-// Dumps parameter values as a JSON string. The `output` member is not dumped.
+// Dumps parameter values as a JSON string. The `output` and `profile` members
+// are not dumped.
 std::string dump_simulation_config(simulation_config const& config);
 
 
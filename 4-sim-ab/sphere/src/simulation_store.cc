@@ -74,3 +74,11 @@ simulation_store::save_snapshot(md::step step, md::array_view<md::point const> p
     keys.push_back(key);
     keys_dataset.write(keys.data(), {keys.size()});
 }
+
+
+void
+simulation_store::save_profile(std::string const& profile)
+{
+    auto dataset = _file.dataset<h5::str>("metadata/profile");
+    dataset.write(profile);
+}
@@ -19,6 +19,7 @@ public:
     void save_beads(md::array_view<bead_data const> beads);
     void save_chains(md::array_view<chain_data const> chains);
     void save_snapshot(md::step step, md::array_view<md::point const> positions);
+    void save_profile(std::string const& profile);
 
 private:
     h5::file _file;
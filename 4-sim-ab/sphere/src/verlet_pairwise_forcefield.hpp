@@ -0,0 +1,87 @@
+#pragma once
+
+#include <utility>
+
+#include <md.hpp>
+
+#include "verlet_pair_list.hpp"
+
+
+// Neighbor pairwise forcefield backed by a Verlet list. The potential must
+// vanish beyond the cutoff distance since the list may contain such pairs.
+template<typename Box, typename PotFn>
+class verlet_pairwise_forcefield : public md::forcefield
+{
+public:
+    explicit verlet_pairwise_forcefield(PotFn potential)
+        : _potential{std::move(potential)}
+    {
+    }
+
+    // Sets the periodic unit cell (or other box type) of the system.
+    verlet_pairwise_forcefield& set_unit_cell(Box const& box)
+    {
+        _pair_list.set_unit_cell(box);
+        return *this;
+    }
+
+    // Sets the cutoff distance of the potential.
+    verlet_pairwise_forcefield& set_neighbor_distance(md::scalar dcut)
+    {
+        _pair_list.set_neighbor_distance(dcut);
+        return *this;
+    }
+
+    // Sets the skin distance. Zero skin rebuilds the list in every step.
+    verlet_pairwise_forcefield& set_verlet_skin(md::scalar skin)
+    {
+        _pair_list.set_verlet_skin(skin);
+        return *this;
+    }
+
+    // Returns the number of times the list has been rebuilt.
+    md::step rebuild_count() const
+    {
+        return _pair_list.rebuild_count();
+    }
+
+    md::scalar compute_energy(md::system const& system) override
+    {
+        auto const positions = system.view_positions();
+        auto const& box = _pair_list.unit_cell();
+        _pair_list.update(positions);
+
+        md::scalar sum = 0;
+        for (auto const& [i, j] : _pair_list.pairs()) {
+            auto const r = detail::displacement(box, positions[i], positions[j]);
+            sum += _potential(i, j).evaluate_energy(r);
+        }
+        return sum;
+    }
+
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override
+    {
+        auto const positions = system.view_positions();
+        auto const& box = _pair_list.unit_cell();
+        _pair_list.update(positions);
+
+        for (auto const& [i, j] : _pair_list.pairs()) {
+            auto const r = detail::displacement(box, positions[i], positions[j]);
+            auto const force = _potential(i, j).evaluate_force(r);
+            forces[i] += force;
+            forces[j] -= force;
+        }
+    }
+
+private:
+    PotFn                 _potential;
+    verlet_pair_list<Box> _pair_list;
+};
+
+
+// Creates a verlet_pairwise_forcefield with given potential function.
+template<typename Box = md::open_box, typename PotFn>
+verlet_pairwise_forcefield<Box, PotFn> make_verlet_pairwise_forcefield(PotFn potential)
+{
+    return verlet_pairwise_forcefield<Box, PotFn>{std::move(potential)};
+}
@@ -5,6 +5,8 @@ import h5py
 import numpy as np
 
 
+from script_common.positions import load_step_positions
+
 from .geometry import Ellipsoid
 
 
@@ -76,7 +78,7 @@ def analyze_distances_history(snapshots):
     for step in snapshots[".steps"]:
         sample = snapshots[step]
         context = json.loads(sample["context"][()])
-        positions = sample["positions"][:]
+        positions = load_step_positions(snapshots, step)
 
         scale = context["bead_scale"]
         wall = Ellipsoid(context["wall_semiaxes"])
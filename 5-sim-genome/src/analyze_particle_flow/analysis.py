@@ -8,6 +8,8 @@ import numba
 import numpy as np
 import scipy.spatial
 
+from script_common.positions import load_positions_history
+
 from .utils import gaussian_smooth
 
 
@@ -164,9 +166,5 @@ def estimate_velocity(positions_history, frame, delay):
 
 
 def load_positions(input):
-    positions_history = []
-    samples = input["snapshots/interphase"]
-    for step in samples[".steps"]:
-        positions = samples[step]["positions"][:]
-        positions_history.append(positions)
-    return np.array(positions_history)
+    _, positions_history = load_positions_history(input["snapshots/interphase"])
+    return positions_history
@@ -7,6 +7,8 @@ import h5py
 import numpy as np
 import scipy.sparse as sparse
 
+from script_common.contacts import open_contact_map
+
 
 TRAJECTORY_FILENAME = "output-*.h5"
 
@@ -61,7 +63,7 @@ def collect_contact_matrix(phase, before, after, chain):
         if "contact_map" not in sample:
             continue
 
-        contact_map_data = sample["contact_map"]
+        contact_map_data = open_contact_map(sample["contact_map"])
 
         # Contact map is a very large sparse matrix in the (i,j,v) format. Let's
         # load triplets by chunk to reduce memory pressure.
@@ -3,6 +3,8 @@ import json
 import h5py
 import numpy as np
 
+from script_common.positions import load_positions_history, load_step_positions
+
 from .utils import gaussian_smooth
 
 
@@ -34,7 +36,7 @@ def run(
 
 def create_data(phase, data):
     init_step = phase[".steps"][0]
-    init_points = phase[init_step]["positions"][:]
+    init_points = load_step_positions(phase, init_step)
 
     metadata = get_metadata(phase)
     chain_ranges = metadata["chromosome_ranges"][:]
@@ -89,14 +91,12 @@ def create_dump(phase, dump, step_range, apart=None, smooth_window=None):
     metadata = get_metadata(phase)
     chain_ranges = metadata["chromosome_ranges"][:]
 
-    points_history = [
-        phase[step]["positions"][:] for step in phase[".steps"]
-    ]
+    steps, points_history = load_positions_history(phase)
 
     if smooth_window:
         points_history = gaussian_smooth(np.array(points_history), window=smooth_window)
 
-    for frame_index, step in enumerate(phase[".steps"]):
+    for frame_index, step in enumerate(steps):
         if step_range is not None:
             if int(step) < step_range[0]:
                 continue
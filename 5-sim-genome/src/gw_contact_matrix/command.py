@@ -6,6 +6,8 @@ import numba
 import numpy as np
 import scipy.sparse
 
+from script_common.contacts import open_contact_map
+
 
 contact_chunk = 1_000_000
 
@@ -73,7 +75,8 @@ def load_contact_matrix_into(inputs, contact_matrix, rebin_map, frame_range=None
                 if "contact_map" not in sample:
                     continue
 
-                for chunk in iterate_chunks(sample["contact_map"], contact_chunk):
+                contact_map = open_contact_map(sample["contact_map"])
+                for chunk in iterate_chunks(contact_map, contact_chunk):
                     collect_contacts(chunk, contact_matrix, rebin_map)
         yield input_index
 
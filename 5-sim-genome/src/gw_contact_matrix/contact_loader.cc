@@ -0,0 +1,540 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <hdf5.h>
+#include <zlib.h>
+#include <highfive/H5DataSet.hpp>
+#include <highfive/H5DataSpace.hpp>
+#include <highfive/H5File.hpp>
+#include <highfive/H5Group.hpp>
+
+#include "../simulation_common/contact_codec.hpp"
+#include "../simulation_common/h5/vector_array.hpp"
+
+#include "contact_loader.hpp"
+#include "contact_matrix.hpp"
+
+
+namespace
+{
+    // A contact map is an (*,3) array of (i, j, count) rows.
+    using contact_row = std::array<std::uint32_t, 3>;
+
+    // Number of rows read at once from a contact map that is not decodable
+    // by this module. Such maps are read through the HDF5 filter pipeline.
+    constexpr std::size_t fallback_read_rows = 1024 * 1024;
+
+    // Layout of the chunks of a one or two-dimensional integer dataset.
+    struct chunk_layout
+    {
+        bool                      decodable = false;
+        std::size_t               elem_size = 0;
+        std::size_t               rows = 0;
+        std::size_t               row_size = 1;
+        std::size_t               chunk_rows = 0;
+        std::vector<H5Z_filter_t> filters;
+    };
+
+    std::mutex& hdf5_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    void load_file(
+        std::string const&  filename,
+        rebin_layout const& layout,
+        frame_range const&  frames,
+        contact_matrix&     matrix
+    );
+
+    void load_triplet_contacts(
+        H5::DataSet const&            dataset,
+        std::unique_lock<std::mutex>& lock,
+        rebin_layout const&           layout,
+        contact_matrix&               matrix
+    );
+
+    void load_csr_contacts(
+        H5::Group const&              group,
+        std::unique_lock<std::mutex>& lock,
+        rebin_layout const&           layout,
+        contact_matrix&               matrix
+    );
+
+    template<typename T>
+    std::vector<T> read_vector(H5::DataSet const& dataset, std::unique_lock<std::mutex>& lock);
+
+    bool read_chunk(
+        H5::DataSet const&          dataset,
+        std::size_t                 start_row,
+        std::vector<unsigned char>& data,
+        unsigned&                   filter_mask
+    );
+
+    std::vector<std::string> select_steps(H5::Group const& phase, frame_range const& frames);
+    chunk_layout inspect_dataset(H5::DataSet const& dataset, std::size_t elem_size);
+
+    void decode_chunk(
+        std::vector<unsigned char>& data,
+        std::vector<unsigned char>& work,
+        chunk_layout const&         chunks,
+        unsigned                    filter_mask
+    );
+
+    void collect_contacts(
+        std::vector<contact_row> const& contacts,
+        rebin_layout const&             layout,
+        contact_matrix&                 matrix
+    );
+
+    template<typename F>
+    void run_unlocked(std::unique_lock<std::mutex>& lock, F func);
+}
+
+
+contact_matrix load_contact_matrix(
+    std::vector<std::string> const& filenames,
+    rebin_layout const&             layout,
+    load_options const&             options
+)
+{
+    auto const jobs = std::max(options.jobs, std::size_t(1));
+
+    std::vector<contact_matrix> matrices(jobs, contact_matrix{layout.bin_count});
+    std::atomic<std::size_t> next_file = 0;
+    std::mutex progress_mutex;
+    std::size_t done_files = 0;
+    std::exception_ptr error;
+
+    auto run_job = [&](std::size_t job) {
+        for (std::size_t k; (k = next_file++) < filenames.size(); ) {
+            try {
+                load_file(filenames[k], layout, options.frames, matrices[job]);
+            } catch (std::exception const& err) {
+                std::lock_guard<std::mutex> lock{progress_mutex};
+                if (!error) {
+                    error = std::make_exception_ptr(
+                        std::runtime_error(filenames[k] + ": " + err.what())
+                    );
+                }
+                next_file = filenames.size();
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock{progress_mutex};
+            done_files++;
+            if (options.progress) {
+                options.progress(done_files);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t job = 1; job < jobs; job++) {
+        threads.emplace_back(run_job, job);
+    }
+    run_job(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    for (std::size_t job = 1; job < jobs; job++) {
+        matrices[0] += matrices[job];
+    }
+
+    return std::move(matrices[0]);
+}
+
+
+namespace
+{
+    // Function: load_file
+    //
+    // Adds the contact maps of the selected interphase frames of a file to
+    // matrix. HDF5 is used only while holding the global lock.
+    //
+    void load_file(
+        std::string const&  filename,
+        rebin_layout const& layout,
+        frame_range const&  frames,
+        contact_matrix&     matrix
+    )
+    {
+        // The lock must outlive the HDF5 objects below, which are closed in
+        // their destructors.
+        std::unique_lock<std::mutex> lock{hdf5_mutex()};
+
+        H5::File store{filename, H5::File::ReadOnly};
+        auto const phase = store.getGroup("snapshots").getGroup("interphase");
+
+        for (auto const& step : select_steps(phase, frames)) {
+            auto const sample = phase.getGroup(step);
+            if (!sample.exist("contact_map")) {
+                continue;
+            }
+
+            if (sample.getObjectType("contact_map") == H5::ObjectType::Group) {
+                load_csr_contacts(sample.getGroup("contact_map"), lock, layout, matrix);
+            } else {
+                load_triplet_contacts(sample.getDataSet("contact_map"), lock, layout, matrix);
+            }
+        }
+    }
+
+
+    // Function: load_triplet_contacts
+    //
+    // Adds an (i,j,v)-formatted contact map to matrix chunk by chunk.
+    //
+    void load_triplet_contacts(
+        H5::DataSet const&            dataset,
+        std::unique_lock<std::mutex>& lock,
+        rebin_layout const&           layout,
+        contact_matrix&               matrix
+    )
+    {
+        auto const chunks = inspect_dataset(dataset, sizeof(std::uint32_t));
+        if (chunks.row_size != 3) {
+            throw std::runtime_error("contact map is not an (*,3) array");
+        }
+
+        std::vector<contact_row> contacts;
+
+        if (!chunks.decodable) {
+            for (std::size_t start = 0; start < chunks.rows; start += fallback_read_rows) {
+                auto const count = std::min(fallback_read_rows, chunks.rows - start);
+                dataset.select({start, 0}, {count, 3}).read(contacts);
+
+                run_unlocked(lock, [&] {
+                    collect_contacts(contacts, layout, matrix);
+                });
+            }
+            return;
+        }
+
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> work;
+
+        for (std::size_t start = 0; start < chunks.rows; start += chunks.chunk_rows) {
+            unsigned filter_mask = 0;
+            if (!read_chunk(dataset, start, data, filter_mask)) {
+                continue;
+            }
+
+            auto const count = std::min(chunks.chunk_rows, chunks.rows - start);
+
+            run_unlocked(lock, [&] {
+                decode_chunk(data, work, chunks, filter_mask);
+                contacts.resize(count);
+                std::memcpy(contacts.data(), data.data(), count * sizeof(contact_row));
+                collect_contacts(contacts, layout, matrix);
+            });
+        }
+    }
+
+
+    // Function: load_csr_contacts
+    //
+    // Adds a CSR-encoded contact map (see contact_codec) to matrix.
+    //
+    void load_csr_contacts(
+        H5::Group const&              group,
+        std::unique_lock<std::mutex>& lock,
+        rebin_layout const&           layout,
+        contact_matrix&               matrix
+    )
+    {
+        std::string format;
+        group.getAttribute("format").read(format);
+        if (format != "csr") {
+            throw std::runtime_error("unknown contact map format: " + format);
+        }
+
+        csr_contacts csr;
+        csr.row_offsets = read_vector<std::uint64_t>(group.getDataSet("row_offsets"), lock);
+        csr.column_deltas = read_vector<std::uint32_t>(group.getDataSet("column_deltas"), lock);
+        csr.counts = read_vector<std::uint8_t>(group.getDataSet("counts"), lock);
+        csr.count_overflows = read_vector<std::uint32_t>(group.getDataSet("count_overflows"), lock);
+
+        run_unlocked(lock, [&] {
+            collect_contacts(decode_csr_contacts(csr), layout, matrix);
+        });
+    }
+
+
+    // Function: read_vector
+    //
+    // Reads a one-dimensional integer dataset. Chunks are decoded with lock
+    // released if possible.
+    //
+    template<typename T>
+    std::vector<T> read_vector(H5::DataSet const& dataset, std::unique_lock<std::mutex>& lock)
+    {
+        auto const chunks = inspect_dataset(dataset, sizeof(T));
+        if (chunks.row_size != 1) {
+            throw std::runtime_error("contact map array is not one-dimensional");
+        }
+
+        std::vector<T> values;
+
+        if (!chunks.decodable) {
+            dataset.read(values);
+            return values;
+        }
+
+        values.resize(chunks.rows);
+
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> work;
+
+        for (std::size_t start = 0; start < chunks.rows; start += chunks.chunk_rows) {
+            unsigned filter_mask = 0;
+            if (!read_chunk(dataset, start, data, filter_mask)) {
+                continue;
+            }
+
+            auto const count = std::min(chunks.chunk_rows, chunks.rows - start);
+
+            run_unlocked(lock, [&] {
+                decode_chunk(data, work, chunks, filter_mask);
+                std::memcpy(values.data() + start, data.data(), count * sizeof(T));
+            });
+        }
+
+        return values;
+    }
+
+
+    // Function: read_chunk
+    //
+    // Reads the stored (filtered) bytes of the chunk starting at given row.
+    // Returns false if the chunk is not allocated, i.e., all zeros.
+    //
+    bool read_chunk(
+        H5::DataSet const&          dataset,
+        std::size_t                 start_row,
+        std::vector<unsigned char>& data,
+        unsigned&                   filter_mask
+    )
+    {
+        hsize_t const offset[] = {start_row, 0};
+        hsize_t stored_size = 0;
+
+        if (H5Dget_chunk_storage_size(dataset.getId(), offset, &stored_size) < 0) {
+            throw std::runtime_error("cannot query contact map chunk");
+        }
+
+        if (stored_size == 0) {
+            return false;
+        }
+
+        data.resize(stored_size);
+
+        if (H5Dread_chunk(dataset.getId(), H5P_DEFAULT, offset, &filter_mask, data.data()) < 0) {
+            throw std::runtime_error("cannot read contact map chunk");
+        }
+
+        return true;
+    }
+
+
+    // Function: select_steps
+    //
+    // Returns the names of the snapshot groups in given frame range.
+    //
+    std::vector<std::string> select_steps(H5::Group const& phase, frame_range const& frames)
+    {
+        std::vector<std::string> steps;
+        phase.getDataSet(".steps").read(steps);
+
+        auto const frame_count = static_cast<std::int64_t>(steps.size());
+        auto const normalize = [=](std::optional<std::int64_t> index, std::int64_t default_index) {
+            if (!index) {
+                return default_index;
+            }
+            auto const i = *index < 0 ? std::max(*index + frame_count, std::int64_t(0)) : *index;
+            return std::min(i, frame_count);
+        };
+
+        auto const start = normalize(frames.start, 0);
+        auto const end = normalize(frames.end, frame_count);
+
+        if (start >= end) {
+            return {};
+        }
+        return {steps.begin() + start, steps.begin() + end};
+    }
+
+
+    // Function: inspect_dataset
+    //
+    // Returns the chunk layout of a one or two-dimensional dataset of
+    // elem_size-byte integers. The chunks are decodable by this module if the
+    // dataset is chunked by rows, the integers are in the native byte order
+    // and the filters are shuffle and deflate, which simulation_store uses.
+    //
+    chunk_layout inspect_dataset(H5::DataSet const& dataset, std::size_t elem_size)
+    {
+        auto const dims = dataset.getSpace().getDimensions();
+        if (dims.empty() || dims.size() > 2) {
+            throw std::runtime_error("contact map array has unexpected rank");
+        }
+
+        chunk_layout chunks;
+        chunks.elem_size = elem_size;
+        chunks.rows = dims[0];
+        chunks.row_size = dims.size() == 2 ? dims[1] : 1;
+
+        auto const dcpl = H5Dget_create_plist(dataset.getId());
+        auto const type = H5Dget_type(dataset.getId());
+
+        auto const rank = static_cast<int>(dims.size());
+        hsize_t chunk_dims[2] = {0, 1};
+
+        chunks.decodable =
+            H5Pget_layout(dcpl) == H5D_CHUNKED &&
+            H5Pget_chunk(dcpl, rank, chunk_dims) == rank &&
+            chunk_dims[0] > 0 &&
+            chunk_dims[1] == (rank == 2 ? dims[1] : 1) &&
+            H5Tget_class(type) == H5T_INTEGER &&
+            H5Tget_size(type) == elem_size &&
+            H5Tget_order(type) == H5Tget_order(H5T_NATIVE_UINT32);
+
+        chunks.chunk_rows = chunk_dims[0];
+
+        auto const filter_count = chunks.decodable ? H5Pget_nfilters(dcpl) : 0;
+
+        for (int k = 0; k < filter_count; k++) {
+            unsigned flags = 0;
+            std::size_t param_count = 0;
+            unsigned filter_config = 0;
+            auto const filter = H5Pget_filter2(
+                dcpl, static_cast<unsigned>(k), &flags, &param_count, nullptr, 0, nullptr, &filter_config
+            );
+            if (filter != H5Z_FILTER_SHUFFLE && filter != H5Z_FILTER_DEFLATE) {
+                chunks.decodable = false;
+            }
+            chunks.filters.push_back(filter);
+        }
+
+        H5Tclose(type);
+        H5Pclose(dcpl);
+
+        return chunks;
+    }
+
+
+    // Function: decode_chunk
+    //
+    // Reverts the filters applied to a stored chunk. Filters are undone in
+    // the reverse order, skipping the ones marked in filter_mask. work is a
+    // scratch buffer.
+    //
+    void decode_chunk(
+        std::vector<unsigned char>& data,
+        std::vector<unsigned char>& work,
+        chunk_layout const&         chunks,
+        unsigned                    filter_mask
+    )
+    {
+        auto const chunk_size = chunks.chunk_rows * chunks.row_size * chunks.elem_size;
+
+        for (auto k = chunks.filters.size(); k-- > 0; ) {
+            if (filter_mask & (1U << k)) {
+                continue;
+            }
+
+            switch (chunks.filters[k]) {
+            case H5Z_FILTER_DEFLATE: {
+                uLongf size = chunk_size;
+                work.resize(chunk_size);
+                auto const status = uncompress(work.data(), &size, data.data(), data.size());
+                if (status != Z_OK || size != chunk_size) {
+                    throw std::runtime_error("corrupted contact map chunk");
+                }
+                data.swap(work);
+                break;
+            }
+
+            case H5Z_FILTER_SHUFFLE: {
+                // Shuffle stores the k-th bytes of all elements contiguously.
+                auto const elem_size = chunks.elem_size;
+                auto const elem_count = data.size() / elem_size;
+                work.resize(data.size());
+                for (std::size_t b = 0; b < elem_size; b++) {
+                    for (std::size_t i = 0; i < elem_count; i++) {
+                        work[i * elem_size + b] = data[b * elem_count + i];
+                    }
+                }
+                data.swap(work);
+                break;
+            }
+
+            default:
+                throw std::logic_error("unexpected filter");
+            }
+        }
+
+        if (data.size() != chunk_size) {
+            throw std::runtime_error("unexpected contact map chunk size");
+        }
+    }
+
+
+    // Function: collect_contacts
+    //
+    // Adds contacts to the bins of matrix. Contacts involving non-chromatin
+    // particles are ignored.
+    //
+    void collect_contacts(
+        std::vector<contact_row> const& contacts,
+        rebin_layout const&             layout,
+        contact_matrix&                 matrix
+    )
+    {
+        auto const& rebin_map = layout.rebin_map;
+        auto const n = rebin_map.size();
+
+        for (auto const& [i, j, v] : contacts) {
+            if (i >= n || j >= n) {
+                continue;
+            }
+            matrix.add_contact(rebin_map[i], rebin_map[j], static_cast<std::int32_t>(v));
+        }
+    }
+
+
+    // Function: run_unlocked
+    //
+    // Calls func with lock released. The lock is re-acquired even if func
+    // throws, so that HDF5 objects are destroyed under the lock.
+    //
+    template<typename F>
+    void run_unlocked(std::unique_lock<std::mutex>& lock, F func)
+    {
+        lock.unlock();
+        try {
+            func();
+        } catch (...) {
+            lock.lock();
+            throw;
+        }
+        lock.lock();
+    }
+}
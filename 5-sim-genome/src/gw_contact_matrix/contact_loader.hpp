@@ -0,0 +1,55 @@
+#pragma once
+
+// This module defines the parallel loader of the contact maps saved in the
+// interphase snapshots of simulation trajectories.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "contact_matrix.hpp"
+
+
+// Struct: frame_range
+//
+// Range of snapshot frames in Python slice semantics. Negative indices count
+// from the last frame and a null bound means the end of the frames.
+//
+struct frame_range
+{
+    std::optional<std::int64_t> start;
+    std::optional<std::int64_t> end;
+};
+
+
+// Struct: load_options
+//
+// Options of load_contact_matrix. progress is called with the number of
+// files loaded so far each time a file is done.
+//
+struct load_options
+{
+    frame_range                      frames;
+    std::size_t                      jobs = 1;
+    std::function<void(std::size_t)> progress;
+};
+
+
+// Function: load_contact_matrix
+//
+// Sums up the contact maps of the frames of given trajectory files into a
+// contact matrix binned with layout.
+//
+// Files are distributed to jobs threads. HDF5 calls are serialized since the
+// library is not thread-safe, but compressed chunks of the contact maps are
+// read as is and decompressed by the threads. Each thread accumulates into
+// its own matrix and the matrices are summed at the end.
+//
+contact_matrix load_contact_matrix(
+    std::vector<std::string> const& filenames,
+    rebin_layout const&             layout,
+    load_options const&             options
+);
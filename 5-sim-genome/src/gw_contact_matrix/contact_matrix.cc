@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hdf5.h>
+#include <highfive/H5DataSet.hpp>
+#include <highfive/H5DataSpace.hpp>
+#include <highfive/H5File.hpp>
+#include <highfive/H5Group.hpp>
+#include <highfive/H5PropertyList.hpp>
+#include <nlohmann/json.hpp>
+
+#include "../simulation_common/h5/vector_array.hpp"
+
+#include "contact_matrix.hpp"
+
+
+namespace
+{
+    // Chunk size of the saved matrix. 256 KiB of int32 elements.
+    constexpr std::size_t matrix_chunk_size = 256;
+
+    void write_chromosome_ranges(H5::Group& group, rebin_layout const& layout);
+}
+
+
+rebin_layout load_rebin_layout(std::string const& filename, std::int32_t rebin_rate)
+{
+    if (rebin_rate < 1) {
+        throw std::runtime_error("rebin rate must be positive");
+    }
+
+    H5::File store{filename, H5::File::ReadOnly};
+    auto const ranges_data = store.getGroup("metadata").getDataSet("chromosome_ranges");
+
+    std::vector<std::array<std::int32_t, 2>> ranges;
+    ranges_data.read(ranges);
+
+    std::string keys_json;
+    ranges_data.getAttribute("keys").read(keys_json);
+
+    rebin_layout layout;
+
+    for (auto const& [name, index] : nlohmann::json::parse(keys_json).items()) {
+        layout.chromosome_keys.emplace_back(name, index.get<std::int32_t>());
+    }
+
+    std::int32_t particle_count = 0;
+    for (auto const& [start, end] : ranges) {
+        particle_count = std::max(particle_count, std::max(start, end));
+    }
+    layout.rebin_map.resize(static_cast<std::size_t>(particle_count));
+
+    std::int32_t chrom_start = 0;
+
+    for (auto const& [start, end] : ranges) {
+        for (auto i = start; i < end; i++) {
+            layout.rebin_map[static_cast<std::size_t>(i)] = chrom_start + (i - start) / rebin_rate;
+        }
+        auto const chrom_end = chrom_start + (end - start + rebin_rate - 1) / rebin_rate;
+        layout.binned_ranges.push_back({chrom_start, chrom_end});
+        chrom_start = chrom_end;
+    }
+
+    layout.bin_count = chrom_start;
+
+    return layout;
+}
+
+
+contact_matrix::contact_matrix(std::int32_t size)
+    : _size{size}
+    , _values(static_cast<std::size_t>(size) * static_cast<std::size_t>(size))
+{
+}
+
+
+contact_matrix& contact_matrix::operator+=(contact_matrix const& other)
+{
+    if (other._size != _size) {
+        throw std::logic_error("contact matrix size mismatch");
+    }
+    for (std::size_t k = 0; k < _values.size(); k++) {
+        _values[k] += other._values[k];
+    }
+    return *this;
+}
+
+
+void save_contact_matrix(
+    std::string const&    filename,
+    contact_matrix const& matrix,
+    rebin_layout const&   layout
+)
+{
+    H5::File store{filename, H5::File::ReadWrite | H5::File::Create | H5::File::Truncate};
+    auto metadata = store.createGroup("metadata");
+
+    write_chromosome_ranges(metadata, layout);
+
+    metadata
+        .createDataSet<std::int32_t>("rebin_map", H5::DataSpace(layout.rebin_map.size()))
+        .write(layout.rebin_map);
+
+    auto const size = static_cast<std::size_t>(matrix.size());
+    auto const chunk = std::max(std::min(size, matrix_chunk_size), std::size_t(1));
+
+    // Same filters as the script: lossless scale-offset, shuffle and gzip.
+    H5::DataSetCreateProps props;
+    props.add(H5::Chunking(chunk, chunk));
+    if (H5Pset_scaleoffset(props.getId(), H5Z_SO_INT, H5Z_SO_INT_MINBITS_DEFAULT) < 0) {
+        throw std::runtime_error("failed to set scale-offset filter");
+    }
+    props.add(H5::Shuffle());
+    props.add(H5::Deflate(1));
+
+    auto dataset = store.createDataSet<std::int32_t>("contact_matrix", H5::DataSpace(size, size), props);
+    if (size > 0) {
+        dataset.write_raw(matrix.values().data());
+    }
+}
+
+
+namespace
+{
+    // Function: write_chromosome_ranges
+    //
+    // Writes binned chromosome ranges as an (*,2) dataset of enum type that
+    // labels chromosome indices with names, as h5py.enum_dtype does.
+    //
+    void write_chromosome_ranges(H5::Group& group, rebin_layout const& layout)
+    {
+        auto const enum_type = H5Tenum_create(H5T_NATIVE_INT32);
+        for (auto const& [name, index] : layout.chromosome_keys) {
+            H5Tenum_insert(enum_type, name.c_str(), &index);
+        }
+
+        hsize_t const dims[] = {layout.binned_ranges.size(), 2};
+        auto const space = H5Screate_simple(2, dims, nullptr);
+        auto const dataset = H5Dcreate2(
+            group.getId(), "chromosome_ranges", enum_type, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT
+        );
+
+        // Enum values are int32, so the ranges are written as is.
+        auto status = dataset < 0 ? -1 : 0;
+        if (status == 0 && !layout.binned_ranges.empty()) {
+            status = H5Dwrite(
+                dataset, enum_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, layout.binned_ranges.data()
+            );
+        }
+
+        if (dataset >= 0) {
+            H5Dclose(dataset);
+        }
+        H5Sclose(space);
+        H5Tclose(enum_type);
+
+        if (status < 0) {
+            throw std::runtime_error("failed to write chromosome ranges");
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+// This module defines the genome-wide contact matrix accumulated from the
+// contact maps of simulation trajectories, and the chromosome-aware binning
+// of particles into the rows of the matrix.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Struct: rebin_layout
+//
+// Assignment of particles to the bins of a contact matrix. rebin_map[i] is
+// the bin of particle i and binned_ranges[c] is the [start, end) range of the
+// bins of the c-th chromosome. Bins do not span chromosome boundaries.
+// chromosome_keys maps chromosome names to the indices.
+//
+struct rebin_layout
+{
+    std::vector<std::int32_t>                         rebin_map;
+    std::vector<std::array<std::int32_t, 2>>          binned_ranges;
+    std::vector<std::pair<std::string, std::int32_t>> chromosome_keys;
+    std::int32_t                                      bin_count = 0;
+};
+
+
+// Function: load_rebin_layout
+//
+// Creates a rebin_layout merging every rebin_rate consecutive particles of
+// each chromosome, using the chromosome ranges saved in a trajectory file.
+//
+rebin_layout load_rebin_layout(std::string const& filename, std::int32_t rebin_rate);
+
+
+// Class: contact_matrix
+//
+// Dense square matrix of contact counts.
+//
+class contact_matrix
+{
+public:
+    explicit contact_matrix(std::int32_t size = 0);
+
+    // Function: size
+    //
+    // Returns the number of rows (and columns).
+    //
+    std::int32_t size() const
+    {
+        return _size;
+    }
+
+    // Function: add_contact
+    //
+    // Adds count to the (i, j) and (j, i) elements. A diagonal element gets
+    // count twice.
+    //
+    void add_contact(std::int32_t i, std::int32_t j, std::int32_t count)
+    {
+        auto const n = static_cast<std::size_t>(_size);
+        auto const u = static_cast<std::size_t>(i);
+        auto const v = static_cast<std::size_t>(j);
+        _values[u * n + v] += count;
+        _values[v * n + u] += count;
+    }
+
+    // Function: operator+=
+    //
+    // Adds other matrix of the same size elementwise.
+    //
+    contact_matrix& operator+=(contact_matrix const& other);
+
+    // Function: values
+    //
+    // Returns the elements in row-major order.
+    //
+    std::vector<std::int32_t> const& values() const
+    {
+        return _values;
+    }
+
+private:
+    std::int32_t              _size;
+    std::vector<std::int32_t> _values;
+};
+
+
+// Function: save_contact_matrix
+//
+// Saves a contact matrix and its layout to a new HDF5 file. The file has the
+// same datasets as the one created by the gw_contact_matrix script:
+// "contact_matrix", "metadata/rebin_map" and "metadata/chromosome_ranges".
+//
+void save_contact_matrix(
+    std::string const&    filename,
+    contact_matrix const& matrix,
+    rebin_layout const&   layout
+);
@@ -0,0 +1,128 @@
+// gw_contact_matrix sums up the contact maps saved in the interphase snapshots
+// of many trajectory files into a genome-wide contact matrix. It is a native
+// counterpart of the Python script of the same name (python -m
+// gw_contact_matrix) and writes the same output format.
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+#include "contact_loader.hpp"
+#include "contact_matrix.hpp"
+
+
+namespace
+{
+    char const* const usage =
+        "usage: gw_contact_matrix [-j jobs] [--frame-range start[:end]]"
+        " [--rebin-rate rate] -o output <trajectory>...\n";
+
+    option const long_options[] = {
+        {"jobs",        required_argument, nullptr, 'j'},
+        {"frame-range", required_argument, nullptr, 'f'},
+        {"rebin-rate",  required_argument, nullptr, 'r'},
+        {"output",      required_argument, nullptr, 'o'},
+        {nullptr,       0,                 nullptr, 0  },
+    };
+
+    frame_range parse_frame_range(std::string const& str);
+}
+
+
+int main(int argc, char** argv)
+{
+    load_options options;
+    std::int32_t rebin_rate = 1;
+    std::string output;
+
+    try {
+        for (int opt; (opt = getopt_long(argc, argv, "j:f:r:o:", long_options, nullptr)) != -1; ) {
+            switch (opt) {
+            case 'j':
+                options.jobs = static_cast<std::size_t>(std::stoul(optarg));
+                break;
+
+            case 'f':
+                options.frames = parse_frame_range(optarg);
+                break;
+
+            case 'r':
+                rebin_rate = static_cast<std::int32_t>(std::stoi(optarg));
+                break;
+
+            case 'o':
+                output = optarg;
+                break;
+
+            default:
+                std::cerr << usage;
+                return 1;
+            }
+        }
+    } catch (std::exception const& err) {
+        std::cerr << "error: bad option value: " << err.what() << '\n';
+        return 1;
+    }
+
+    std::vector<std::string> const inputs(argv + optind, argv + argc);
+
+    if (inputs.empty() || output.empty()) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    options.progress = [](std::size_t done_files) {
+        if ((done_files - 1) % 10 == 0) {
+            std::cerr << done_files - 1;
+        }
+        std::cerr << '.' << std::flush;
+    };
+
+    try {
+        auto const layout = load_rebin_layout(inputs.front(), rebin_rate);
+
+        std::cerr << "Loading: " << std::flush;
+        auto const matrix = load_contact_matrix(inputs, layout, options);
+        std::cerr << " DONE\n";
+
+        save_contact_matrix(output, matrix, layout);
+    } catch (std::exception const& err) {
+        std::cerr << "\nerror: " << err.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
+
+
+namespace
+{
+    // Parses "start[:end]" into a frame range. Empty end means the last
+    // frame.
+    frame_range parse_frame_range(std::string const& str)
+    {
+        frame_range range;
+
+        auto const colon = str.find(':');
+        auto const start = str.substr(0, colon);
+
+        if (!start.empty()) {
+            range.start = std::stoll(start);
+        }
+
+        if (colon != std::string::npos) {
+            auto const end = str.substr(colon + 1);
+            if (!end.empty()) {
+                range.end = std::stoll(end);
+            }
+        }
+
+        return range;
+    }
+}
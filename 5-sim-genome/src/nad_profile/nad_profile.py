@@ -7,6 +7,8 @@ import h5py
 import numpy as np
 import scipy.sparse as sparse
 
+from script_common.contacts import open_contact_map
+
 
 TRAJECTORY_FILENAME = "output-*.h5"
 
@@ -64,6 +66,15 @@ def collect_nucleolus_contacts(phase, before, after, chain):
     if after is not None:
         sample_steps = [step for step in sample_steps if step >= after]
 
+    # Nucleolus contacts counted in the simulation cover all contacts, so use
+    # only them if saved. Otherwise scan contact maps.
+    if any("nucleolus_contacts" in phase[str(step)] for step in sample_steps):
+        for step in sample_steps:
+            sample = phase[str(step)]
+            if "nucleolus_contacts" in sample:
+                contact_profile += sample["nucleolus_contacts"][beg:end].astype(np.int32)
+        return contact_profile
+
     for step in sample_steps:
         sample = phase[str(step)]
 
@@ -71,7 +82,7 @@ def collect_nucleolus_contacts(phase, before, after, chain):
         if "contact_map" not in sample:
             continue
 
-        contact_map_data = sample["contact_map"]
+        contact_map_data = open_contact_map(sample["contact_map"])
 
         # Contact map is a very large sparse matrix in the (i,j,v) format. Let's
         # load triplets by chunk to reduce memory pressure.
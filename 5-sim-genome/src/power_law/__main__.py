@@ -11,6 +11,7 @@ def main():
 
 def parse_args():
     parser = argparse.ArgumentParser()
+    parser.add_argument("--all-frames", action="store_true")
     parser.add_argument("trajfiles", type=str, nargs="+")
     return vars(parser.parse_args())
 
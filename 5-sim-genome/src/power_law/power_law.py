@@ -6,20 +6,22 @@ import numpy as np
 from scipy import sparse
 from sklearn.linear_model import LinearRegression
 
+from script_common.contacts import open_contact_map
+
 
 NEAR_RANGE = 3, 20
 LONG_RANGE = 20, 100
 FAR_RANGE = 100, 1500
 
 
-def run(trajfiles):
+def run(trajfiles, all_frames):
     for trajfile in trajfiles:
-        run_once(trajfile)
+        run_once(trajfile, all_frames=all_frames)
 
 
-def run_once(trajfile):
+def run_once(trajfile, *, all_frames):
     with h5py.File(trajfile, "r") as store:
-        contact_profile = compute_contact_profile(store)
+        contact_profile = compute_contact_profile(store, all_frames=all_frames)
     distances = np.arange(len(contact_profile))
 
     beg, end = NEAR_RANGE
@@ -32,7 +34,7 @@ def run_once(trajfile):
     print(f"{near_exp:g}\t{long_exp:g}\t{far_exp:g}")
 
 
-def compute_contact_profile(store):
+def compute_contact_profile(store, *, all_frames):
     particle_types = store["metadata/particle_types"]
     chromosome_ranges = store["metadata/chromosome_ranges"]
 
@@ -49,15 +51,53 @@ def compute_contact_profile(store):
     interphase = store["snapshots/interphase"]
     steps = interphase[".steps"]
 
+    # Use contact profiles accumulated in the simulation if saved. These need
+    # no scan of contact maps. Like a contact map, each profile frame counts
+    # the contacts since the previous frame, so the last frame covers the same
+    # window as the last contact map.
+    if all_frames:
+        contact_profile = sum_contact_distances(interphase, steps)
+    else:
+        contact_profile = last_contact_distances(interphase, steps)
+    if contact_profile is not None:
+        return contact_profile
+
     for step in reversed(steps):
         sample = interphase[step]
         if "contact_map" in sample:
-            contacts = sample["contact_map"]
+            contacts = open_contact_map(sample["contact_map"])
             break
 
     return collect_contact_profile(contacts, chain_ids, size=max_chain_size)
 
 
+def last_contact_distances(phase, steps):
+    for step in reversed(steps):
+        sample = phase[step]
+        if "contact_distances" in sample:
+            # (chromosomes, distance) matrix.
+            return sample["contact_distances"][:].sum(axis=0).astype(np.int64)
+    return None
+
+
+def sum_contact_distances(phase, steps):
+    contact_profile = None
+
+    for step in steps:
+        sample = phase[step]
+        if "contact_distances" not in sample:
+            continue
+
+        # (chromosomes, distance) matrix.
+        contact_distances = sample["contact_distances"][:].sum(axis=0)
+        if contact_profile is None:
+            contact_profile = contact_distances.astype(np.int64)
+        else:
+            contact_profile += contact_distances
+
+    return contact_profile
+
+
 def collect_contact_profile(contacts, chain_ids, *, size):
     contact_profile = np.zeros(size, dtype=np.int32)
 
@@ -4,6 +4,9 @@ DEFAULT_CONFIG = OrderedDict({
 "b_core_diameter": 0.2,
 "a_core_repulsion": 2.0,
 "b_core_repulsion": 2.0,
+"repulsion_method": "table",
+"neighbor_skin": 0.0,
+"neighbor_reorder_interval": 0,
 "chromatin_bond_spring": 0.1,
 "chromatin_bond_length": 0.2,
 "chromatin_mobility": 1.0,
@@ -35,6 +38,7 @@ DEFAULT_CONFIG = OrderedDict({
 "init_coarse_graining": 100,
 "init_bead_diameter": 0.2,
 "init_bead_repulsion": 5.0,
+"init_neighbor_skin": 0.0,
 "init_bond_length": 0.2,
 "init_bond_spring": 500.0,
 "init_bend_energy": 0.0,
@@ -65,9 +69,21 @@ DEFAULT_CONFIG = OrderedDict({
 "interphase_steps": 10000,
 "interphase_sampling_interval": 1000,
 "interphase_logging_interval": 100,
+"interphase_repulsion_interval": 1,
 "contactmap_distance": 0.4,
 "contactmap_update_interval": 100,
 "contactmap_thinning_rate": 100,
+"contactmap_band_width": 64,
+"contactmap_distance_tolerance": 0.05,
+"contactmap_search": "separate",
+"contactmap_format": "csr",
+"contactprofile_thinning_rate": 0,
 "spindle_seed": 0,
 "interphase_seed": 0,
+"simulation_threads": 1,
+"energy_method": "separate",
+"checkpoint_interval": 0,
+"store_queue_size": 0,
+"position_format": "delta",
+"position_layout": "snapshot",
 })
@@ -3,6 +3,8 @@ import json
 import h5py
 import numpy as np
 
+from script_common.positions import load_step_positions, save_step_positions
+
 from .refinement import get_refinement_method
 
 
@@ -21,7 +23,7 @@ def run(*, trajfile):
 
         init = store["snapshots/packing"]
         init_chains = init["metadata/chromosome_ranges"][:]
-        init_positions = init[init[".steps"][-1]]["positions"][:]
+        init_positions = load_step_positions(init, init[".steps"][-1])
 
         fine_positions = np.empty((particle_count, 3))
 
@@ -39,8 +41,7 @@ def run(*, trajfile):
         for nor, nuc in nucleo_bonds:
             fine_positions[nuc] = fine_positions[nor]
 
-        # Save as the initial conformation of relax phase simulation.
-        phase = store["snapshots/relaxation"]
-        if "0" in phase:
-            del phase["0"]
-        phase["0/positions"] = fine_positions
+        # Save as the initial conformation of relax phase simulation. This
+        # replaces the conformation saved by simulation_spindle in either
+        # position layout.
+        save_step_positions(store["snapshots/relaxation"], 0, fine_positions)
@@ -0,0 +1,109 @@
+"""
+This module defines a read-only view of contact maps saved in trajectory
+files. Contact maps are saved either as an (i,j,v)-formatted dataset or as a
+group of CSR-encoded arrays. The view presents the latter as the former.
+"""
+
+from typing import Union
+
+import h5py
+import numpy as np
+
+
+_CSR_FORMAT = "csr"
+_CSR_COUNT_ESCAPE = 255
+_DEFAULT_CHUNK_ROWS = 1024 * 1024
+
+
+def open_contact_map(node: Union[h5py.Dataset, h5py.Group]):
+    """
+    Returns an (i,j,v)-formatted array-like view of a contact map node. A
+    legacy (i,j,v) dataset is returned as is.
+    """
+    if isinstance(node, h5py.Dataset):
+        return node
+    contact_format = node.attrs.get("format")
+    if isinstance(contact_format, bytes):
+        contact_format = contact_format.decode()
+    if contact_format == _CSR_FORMAT:
+        return CSRContactMap(node)
+    raise ValueError(f"unknown contact map format: {node.name}")
+
+
+class CSRContactMap:
+    """
+    Array-like view of a CSR-encoded contact map. Supports shape, chunks,
+    len() and slicing by entries, e.g. `view[start:end]` or
+    `view[start:end, :]`, which returns an (n,3) uint32 array.
+    """
+    def __init__(self, group: h5py.Group):
+        self._row_offsets = group["row_offsets"][:].astype(np.int64)
+        self._column_deltas = group["column_deltas"]
+
+        # Counts are a byte per entry. Entries with large counts are escaped,
+        # and the cumulative number of escapes locates their values.
+        counts = group["counts"][:]
+        escaped = counts == _CSR_COUNT_ESCAPE
+        self._counts = counts
+        self._escape_offsets = np.concatenate(([0], np.cumsum(escaped)))
+        self._count_overflows = group["count_overflows"][:]
+
+        self.shape = (len(counts), 3)
+        self.dtype = np.dtype(np.uint32)
+        self.chunks = (self._column_deltas.chunks or (_DEFAULT_CHUNK_ROWS,))[:1] + (3,)
+
+    def __len__(self):
+        return self.shape[0]
+
+    def __getitem__(self, key):
+        if isinstance(key, tuple):
+            key, *columns = key
+        else:
+            columns = []
+
+        if key is Ellipsis:
+            key = slice(None)
+        if not isinstance(key, slice):
+            raise TypeError("CSR contact map supports slicing only")
+
+        start, end, step = key.indices(self.shape[0])
+        entries = self._decode(start, max(start, end))
+        if step != 1:
+            entries = entries[::step]
+        if columns:
+            entries = entries[(slice(None), *columns)]
+        return entries
+
+    def __array__(self, dtype=None):
+        entries = self[:]
+        return entries if dtype is None else entries.astype(dtype)
+
+    def _decode(self, start, end):
+        entries = np.empty((end - start, 3), dtype=np.uint32)
+        if start == end:
+            return entries
+
+        # Column deltas are relative within a row, so decode from the start
+        # of the row containing the first entry.
+        rows = np.searchsorted(self._row_offsets, np.arange(start, end), side="right") - 1
+        first_row_start = self._row_offsets[rows[0]]
+
+        deltas = self._column_deltas[first_row_start:end].astype(np.int64)
+        sums = np.cumsum(deltas)
+
+        # Subtract the sum up to the start of each row.
+        row_starts = self._row_offsets[rows] - first_row_start
+        base = np.where(row_starts > 0, sums[row_starts - 1], 0)
+        offset = start - first_row_start
+        columns = rows + sums[offset:] - base
+
+        counts = self._counts[start:end].astype(np.uint32)
+        escaped = counts == _CSR_COUNT_ESCAPE
+        if escaped.any():
+            first = self._escape_offsets[start]
+            counts[escaped] = self._count_overflows[first:first + escaped.sum()]
+
+        entries[:, 0] = rows
+        entries[:, 1] = columns
+        entries[:, 2] = counts
+        return entries
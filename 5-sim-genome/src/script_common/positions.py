@@ -0,0 +1,139 @@
+"""
+This module defines readers and a writer of particle positions saved in
+trajectory files. Positions of a step are saved in the snapshot group either
+as an (n,3) float32 dataset or as a group of bit-packed fixed-point residuals
+(see simulation_common/position_codec.hpp). Alternatively, positions of all
+steps in a phase are saved in a (frames,n,3) dataset.
+"""
+
+from typing import Optional, Tuple, Union
+
+import h5py
+import numpy as np
+
+
+_DELTA_FORMAT = "delta"
+_BLOCK_SIZE = 64
+
+_DATASET_POSITIONS = "positions"
+_DATASET_HISTORY = "positions_history"
+_DATASET_HISTORY_STEPS = "positions_history_steps"
+_DATASET_STEPS = ".steps"
+
+
+def load_positions_history(
+    phase: h5py.Group, start: Optional[int] = None, end: Optional[int] = None
+) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Returns the steps and the (frames,n,3) positions of the frames of a phase
+    in the step range [start, end). The range is open if None. A phase saved
+    in the history layout is read by a single hyperslab read.
+    """
+    if _DATASET_HISTORY in phase:
+        steps = phase[_DATASET_HISTORY_STEPS][:]
+        beg_index = 0 if start is None else np.searchsorted(steps, start)
+        end_index = len(steps) if end is None else np.searchsorted(steps, end)
+        return steps[beg_index:end_index], phase[_DATASET_HISTORY][beg_index:end_index]
+
+    steps = []
+    positions_history = []
+    for key in phase[_DATASET_STEPS]:
+        step = int(key)
+        if start is not None and step < start:
+            continue
+        if end is not None and step >= end:
+            continue
+        sample = phase[str(step)]
+        if _DATASET_POSITIONS in sample:
+            steps.append(step)
+            positions_history.append(load_positions(sample[_DATASET_POSITIONS]))
+
+    if not positions_history:
+        return np.array(steps, dtype=np.int64), np.empty((0, 0, 3), dtype=np.float32)
+    return np.array(steps, dtype=np.int64), np.array(positions_history)
+
+
+def load_step_positions(phase: h5py.Group, step: Union[int, str]) -> np.ndarray:
+    """
+    Returns an (n,3) float32 array of the positions saved at a step of a phase
+    in either layout.
+    """
+    step = int(step)
+    if _DATASET_HISTORY in phase:
+        steps = phase[_DATASET_HISTORY_STEPS][:]
+        frame = np.searchsorted(steps, step)
+        if frame < len(steps) and steps[frame] == step:
+            return phase[_DATASET_HISTORY][frame]
+    return load_positions(phase[str(step)][_DATASET_POSITIONS])
+
+
+def save_step_positions(phase: h5py.Group, step: Union[int, str], positions: np.ndarray):
+    """
+    Overwrites the positions saved at a step of a phase. If the phase has a
+    frame of the step in the history layout, the frame is overwritten since it
+    takes precedence over the snapshot group. Otherwise positions are saved as
+    an (n,3) float32 dataset in the snapshot group.
+    """
+    step = int(step)
+    positions = np.asarray(positions, dtype=np.float32)
+
+    if _DATASET_HISTORY in phase:
+        steps = phase[_DATASET_HISTORY_STEPS][:]
+        frame = np.searchsorted(steps, step)
+        if frame < len(steps) and steps[frame] == step:
+            history = phase[_DATASET_HISTORY]
+            if history.shape[1:] != positions.shape:
+                raise ValueError(f"positions do not match the history: {history.name}")
+            history[frame] = positions
+            return
+
+    sample = phase.require_group(str(step))
+    if _DATASET_POSITIONS in sample:
+        del sample[_DATASET_POSITIONS]
+    sample[_DATASET_POSITIONS] = positions
+
+
+def load_positions(node: Union[h5py.Dataset, h5py.Group]) -> np.ndarray:
+    """
+    Returns an (n,3) float32 array of the positions saved in a node.
+    """
+    if isinstance(node, h5py.Dataset):
+        return node[:]
+
+    position_format = node.attrs.get("format")
+    if isinstance(position_format, bytes):
+        position_format = position_format.decode()
+    if position_format != _DELTA_FORMAT:
+        raise ValueError(f"unknown position format: {node.name}")
+
+    point_count = int(node.attrs["point_count"])
+    fraction_bits = int(node.attrs["fraction_bits"])
+    widths = node["widths"][:].astype(np.int64)
+    payload = node["payload"][:]
+
+    value_count = point_count * 3
+    if value_count == 0:
+        return np.empty((0, 3), dtype=np.float32)
+
+    # Bit offset of each value. A block takes its width times the number of
+    # its values bits.
+    value_indices = np.arange(value_count)
+    blocks = value_indices // _BLOCK_SIZE
+    value_widths = widths[blocks]
+    block_starts = np.concatenate(([0], np.cumsum(widths * _BLOCK_SIZE)[:-1]))
+    bit_starts = block_starts[blocks] + (value_indices % _BLOCK_SIZE) * value_widths
+
+    # Pad so that reading the widest value at the end stays in bounds.
+    bits = np.unpackbits(payload, bitorder="little")
+    bits = np.concatenate((bits, np.zeros(int(widths.max()), dtype=np.uint8)))
+
+    values = np.zeros(value_count, dtype=np.int64)
+    for bit in range(int(widths.max())):
+        selector = value_widths > bit
+        values[selector] |= bits[bit_starts[selector] + bit].astype(np.int64) << bit
+
+    # Undo zigzag encoding and the prediction from the previous particle.
+    residuals = (values >> 1) ^ -(values & 1)
+    fixed_points = residuals.reshape(point_count, 3).cumsum(axis=0)
+
+    return (fixed_points * 2.0 ** -fraction_bits).astype(np.float32)
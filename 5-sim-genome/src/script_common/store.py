@@ -11,6 +11,9 @@ from types import SimpleNamespace
 import h5py
 import numpy as np
 
+from .contacts import open_contact_map
+from .positions import load_step_positions
+
 
 _GROUP_PHASE_PARENT = "snapshots"
 _GROUP_METADATA = "metadata"
@@ -22,8 +25,8 @@ _DATASET_CHROMOSOME_RANGES = "chromosome_ranges"
 _DATASET_CENTROMERE_RANGES = "centromere_ranges"
 _DATASET_NUCLEOLUS_RANGES = "nucleolus_ranges"
 _DATASET_STEPS = ".steps"
+_DATASET_STEP_INDEX = ".step_index"
 _DATASET_CONTEXT = "context"
-_DATASET_POSITIONS = "positions"
 _DATASET_CONTACT_MAP = "contact_map"
 
 
@@ -79,7 +82,7 @@ class Snapshot:
         """
         Returns an array of coordinate values of the particles.
         """
-        return self._node[_DATASET_POSITIONS][:]
+        return load_step_positions(self._node.parent, self._step)
 
     @property
     def context(self) -> SimpleNamespace:
@@ -89,12 +92,13 @@ class Snapshot:
         return SimpleNamespace(**json.loads(self._node[_DATASET_CONTEXT][()]))
 
     @property
-    def contact_map_dataset(self) -> Optional[h5py.Dataset]:
+    def contact_map_dataset(self) -> Optional[Any]:
         """
-        Returns a dataset containing (i,j,v)-formatted contact map, if any.
+        Returns a dataset or a dataset-like view containing (i,j,v)-formatted
+        contact map, if any.
         """
         if _DATASET_CONTACT_MAP in self._node:
-            return self._node[_DATASET_CONTACT_MAP]
+            return open_contact_map(self._node[_DATASET_CONTACT_MAP])
         return None
 
 
@@ -124,11 +128,19 @@ class Phase:
 
 def _make_snapshots(branch):
     snapshots = []
-    for step in branch[_DATASET_STEPS]:
-        snapshots.append(Snapshot(branch[step], int(step)))
+    for step in _load_steps(branch):
+        snapshots.append(Snapshot(branch[str(step)], step))
     return snapshots
 
 
+def _load_steps(branch):
+    # Newer trajectories have an integer step index. Older ones only have the
+    # string list, which is still written along with the index.
+    if _DATASET_STEP_INDEX in branch:
+        return [int(step) for step in branch[_DATASET_STEP_INDEX][:]]
+    return [int(step) for step in branch[_DATASET_STEPS]]
+
+
 def _make_phase_metadata(branch):
     default_metadata = branch.file[_GROUP_METADATA]
     if _GROUP_METADATA in branch:
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <md.hpp>
+
+#include "adaptive_dynamics.hpp"
+
+
+void simulate_adaptive_brownian_dynamics(
+    md::system&                         system,
+    md::brownian_dynamics_config const& config,
+    adaptive_dynamics_stats&            stats
+)
+{
+    if (config.spacestep <= 0) {
+        throw std::runtime_error("adaptive dynamics needs a positive spacestep");
+    }
+
+    std::mt19937_64 random{config.seed};
+    std::normal_distribution<md::scalar> normal;
+
+    auto const positions = system.view_positions();
+    auto const mobilities = system.view_mobilities();
+    std::vector<md::vector> forces(system.particle_count());
+
+    for (md::step step = 1; step <= config.steps; step++) {
+        std::fill(forces.begin(), forces.end(), md::vector{});
+        system.compute_force(forces);
+
+        // The fastest drifting particle determines the timestep.
+        md::scalar max_speed = 0;
+        for (md::index i = 0; i < forces.size(); i++) {
+            max_speed = std::max(max_speed, mobilities[i] * forces[i].norm());
+        }
+
+        auto timestep = config.timestep;
+        if (max_speed * timestep > config.spacestep) {
+            timestep = config.spacestep / max_speed;
+            stats.limited_steps++;
+        }
+
+        for (md::index i = 0; i < forces.size(); i++) {
+            auto const mu = mobilities[i];
+            auto const sigma = std::sqrt(2 * config.temperature * mu * timestep);
+            auto const noise = md::vector {
+                normal(random), normal(random), normal(random)
+            };
+            positions[i] += mu * timestep * forces[i] + sigma * noise;
+        }
+
+        stats.time += timestep;
+        stats.timestep = timestep;
+        stats.steps++;
+
+        if (config.callback) {
+            config.callback(step);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// This module defines a Brownian dynamics integrator that adapts the timestep
+// to the forces acting on the particles.
+
+#include <md.hpp>
+
+
+// Struct: adaptive_dynamics_stats
+//
+// Statistics of simulate_adaptive_brownian_dynamics. The integrator adds to
+// the fields, so a caller can accumulate statistics over multiple runs.
+//
+struct adaptive_dynamics_stats
+{
+    // Simulated time.
+    md::scalar time = 0;
+
+    // Timestep taken in the last step.
+    md::scalar timestep = 0;
+
+    // Number of steps taken and the number of those shortened to keep the
+    // drift within the spacestep.
+    md::step steps         = 0;
+    md::step limited_steps = 0;
+};
+
+
+// Function: simulate_adaptive_brownian_dynamics
+//
+// Simulates overdamped Langevin dynamics like md::simulate_brownian_dynamics,
+// but each step takes the largest timestep, up to config.timestep, with which
+// no particle drifts more than config.spacestep. The thermal noise is not
+// limited. config.spacestep must be positive.
+//
+// config.callback is called with the step number after each step, as in
+// md::simulate_brownian_dynamics. stats is updated before the call.
+//
+void simulate_adaptive_brownian_dynamics(
+    md::system&                         system,
+    md::brownian_dynamics_config const& config,
+    adaptive_dynamics_stats&            stats
+);
@@ -0,0 +1,23 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <md.hpp>
+
+#include "command_line.hpp"
+
+
+bool parse_index(char const* text, md::index& value)
+{
+    try {
+        std::size_t end;
+        auto const parsed = std::stoul(text, &end);
+        if (text[end] != '\0') {
+            return false;
+        }
+        value = static_cast<md::index>(parsed);
+        return true;
+    } catch (std::logic_error const&) {
+        return false;
+    }
+}
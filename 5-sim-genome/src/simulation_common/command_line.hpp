@@ -0,0 +1,14 @@
+#pragma once
+
+// This module defines helpers for parsing command-line arguments of the
+// simulators.
+
+#include <md.hpp>
+
+
+// Function: parse_index
+//
+// Parses a non-negative integer. Returns false, leaving value unchanged, if
+// text is not one.
+//
+bool parse_index(char const* text, md::index& value);
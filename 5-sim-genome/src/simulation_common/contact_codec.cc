@@ -0,0 +1,98 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "contact_codec.hpp"
+
+
+csr_contacts encode_csr_contacts(std::vector<std::array<std::uint32_t, 3>> const& contacts)
+{
+    csr_contacts csr;
+    csr.column_deltas.reserve(contacts.size());
+    csr.counts.reserve(contacts.size());
+
+    // Rows [0, row_count) have been started and the last one is current.
+    std::size_t row_count = 0;
+    std::uint32_t prev_j = 0;
+
+    for (std::size_t k = 0; k < contacts.size(); k++) {
+        auto const [i, j, count] = contacts[k];
+
+        if (j < i) {
+            throw std::invalid_argument("contact entry must satisfy i <= j");
+        }
+
+        if (i >= row_count) {
+            // Rows skipped in between have no entry.
+            while (row_count <= i) {
+                csr.row_offsets.push_back(k);
+                row_count++;
+            }
+            csr.column_deltas.push_back(j - i);
+        } else if (i + std::size_t(1) == row_count && j > prev_j) {
+            csr.column_deltas.push_back(j - prev_j);
+        } else {
+            throw std::invalid_argument("contact entries must be ordered by (i, j)");
+        }
+        prev_j = j;
+
+        if (count < csr_count_escape) {
+            csr.counts.push_back(static_cast<std::uint8_t>(count));
+        } else {
+            csr.counts.push_back(csr_count_escape);
+            csr.count_overflows.push_back(count);
+        }
+    }
+
+    csr.row_offsets.push_back(contacts.size());
+
+    return csr;
+}
+
+
+std::vector<std::array<std::uint32_t, 3>> decode_csr_contacts(csr_contacts const& csr)
+{
+    auto const entry_count = csr.column_deltas.size();
+
+    if (csr.counts.size() != entry_count ||
+        csr.row_offsets.empty() ||
+        csr.row_offsets.front() != 0 ||
+        csr.row_offsets.back() != entry_count) {
+        throw std::runtime_error("inconsistent CSR contact map");
+    }
+
+    std::vector<std::array<std::uint32_t, 3>> contacts;
+    contacts.reserve(entry_count);
+
+    std::size_t overflow = 0;
+
+    for (std::size_t row = 0; row + 1 < csr.row_offsets.size(); row++) {
+        auto const begin = csr.row_offsets[row];
+        auto const end = csr.row_offsets[row + 1];
+
+        if (begin > end || end > entry_count) {
+            throw std::runtime_error("inconsistent CSR contact map");
+        }
+
+        auto const i = static_cast<std::uint32_t>(row);
+        auto j = i;
+
+        for (auto k = begin; k < end; k++) {
+            j += csr.column_deltas[k];
+
+            std::uint32_t count = csr.counts[k];
+            if (count == csr_count_escape) {
+                if (overflow >= csr.count_overflows.size()) {
+                    throw std::runtime_error("inconsistent CSR contact map");
+                }
+                count = csr.count_overflows[overflow++];
+            }
+
+            contacts.push_back({i, j, count});
+        }
+    }
+
+    return contacts;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// This module defines the compressed sparse row (CSR) encoding of contact
+// maps saved in trajectory files. A contact map is a list of (i, j, count)
+// entries ordered by (i, j) with i <= j, as returned by contact_map.
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+// Struct: csr_contacts
+//
+// CSR-encoded contact map. Entries of row i are in the range
+// [row_offsets[i], row_offsets[i + 1]). column_deltas of the first entry of a
+// row is j - i, and that of the others is the difference from the previous
+// column. Counts less than 255 are stored in counts as is. Larger counts are
+// stored as 255 in counts and the value is stored in count_overflows, in the
+// order of the entries.
+//
+struct csr_contacts
+{
+    std::vector<std::uint64_t> row_offsets;
+    std::vector<std::uint32_t> column_deltas;
+    std::vector<std::uint8_t>  counts;
+    std::vector<std::uint32_t> count_overflows;
+};
+
+
+// Constant: csr_count_escape
+//
+// Value in csr_contacts::counts telling that the count is in count_overflows.
+//
+constexpr std::uint8_t csr_count_escape = 255;
+
+
+// Function: encode_csr_contacts
+//
+// Encodes (i, j, count) entries into CSR format. Throws std::invalid_argument
+// if the entries are not ordered by (i, j) or some entry has i > j.
+//
+csr_contacts encode_csr_contacts(std::vector<std::array<std::uint32_t, 3>> const& contacts);
+
+
+// Function: decode_csr_contacts
+//
+// Decodes CSR format back into (i, j, count) entries. Throws
+// std::runtime_error if the data is inconsistent.
+//
+std::vector<std::array<std::uint32_t, 3>> decode_csr_contacts(csr_contacts const& csr);
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "energy_monitor.hpp"
+
+
+md::index energy_monitor::add_component(std::string const& name)
+{
+    _names.push_back(name);
+    _energies.push_back(0);
+    return _names.size() - 1;
+}
+
+
+md::index energy_monitor::find_component(std::string const& name) const
+{
+    auto const it = std::find(_names.begin(), _names.end(), name);
+    if (it == _names.end()) {
+        throw std::runtime_error("unknown energy component: " + name);
+    }
+    return static_cast<md::index>(it - _names.begin());
+}
+
+
+void energy_monitor::add_forcefield(
+    std::string const& name, std::shared_ptr<md::forcefield> forcefield
+)
+{
+    auto const component = add_component(name);
+    _forcefields.push_back({component, std::move(forcefield)});
+}
+
+
+void energy_monitor::set_requested(bool requested)
+{
+    _requested = requested;
+    _available = false;
+}
+
+
+bool energy_monitor::is_requested() const
+{
+    return _requested;
+}
+
+
+void energy_monitor::record(md::index component, md::scalar energy)
+{
+    _energies[component] = energy;
+}
+
+
+void energy_monitor::finish(md::system const& system)
+{
+    if (!_requested) {
+        return;
+    }
+
+    for (auto const& [component, forcefield] : _forcefields) {
+        _energies[component] = forcefield->compute_energy(system);
+    }
+
+    _requested = false;
+    _available = true;
+}
+
+
+bool energy_monitor::is_available() const
+{
+    return _available;
+}
+
+
+md::scalar energy_monitor::total_energy() const
+{
+    return std::accumulate(_energies.begin(), _energies.end(), md::scalar(0));
+}
+
+
+std::vector<std::string> const& energy_monitor::names() const
+{
+    return _names;
+}
+
+
+std::vector<md::scalar> const& energy_monitor::energies() const
+{
+    return _energies;
+}
+
+
+energy_monitor_forcefield::energy_monitor_forcefield(std::shared_ptr<energy_monitor> monitor)
+    : _monitor{std::move(monitor)}
+{
+}
+
+
+md::scalar energy_monitor_forcefield::compute_energy(md::system const&)
+{
+    return 0;
+}
+
+
+void energy_monitor_forcefield::compute_force(md::system const& system, md::array_view<md::vector>)
+{
+    _monitor->finish(system);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+// This module defines energy_monitor class, which collects potential energies
+// as a side product of a force evaluation.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <md.hpp>
+
+
+// Class: energy_monitor
+//
+// Collects the potential energy of each forcefield during the force evaluation
+// of a requested step, so that the energy of the system is available without
+// a separate pass over all the forcefields.
+//
+// Forcefields that can compute energy along with forces (the parallel pairwise
+// forcefields) record their energy to a component. Other forcefields are
+// registered with add_forcefield and evaluated by energy_monitor_forcefield,
+// which must be added to the system after all the other forcefields.
+//
+// Note that the energies are those of the configuration the forces are
+// evaluated on, i.e., the one just before the integration step.
+//
+class energy_monitor
+{
+public:
+    // Function: add_component
+    //
+    // Adds a named energy component and returns its index.
+    //
+    md::index add_component(std::string const& name);
+
+    // Function: find_component
+    //
+    // Returns the index of the named component. Throws std::runtime_error if
+    // no component has the name.
+    //
+    md::index find_component(std::string const& name) const;
+
+    // Function: add_forcefield
+    //
+    // Adds a named energy component that is computed by calling
+    // forcefield->compute_energy in the requested force evaluation.
+    //
+    void add_forcefield(std::string const& name, std::shared_ptr<md::forcefield> forcefield);
+
+    // Function: set_requested
+    //
+    // Sets whether energies are computed in the next force evaluation. This
+    // discards the energies computed so far.
+    //
+    void set_requested(bool requested);
+
+    // Function: is_requested
+    //
+    // Returns true if energies are to be computed in the current force
+    // evaluation.
+    //
+    bool is_requested() const;
+
+    // Function: record
+    //
+    // Records the energy of a component. Called by forcefields.
+    //
+    void record(md::index component, md::scalar energy);
+
+    // Function: finish
+    //
+    // Computes the energies of registered forcefields and makes the energies
+    // available. Called by energy_monitor_forcefield.
+    //
+    void finish(md::system const& system);
+
+    // Function: is_available
+    //
+    // Returns true if the energies have been computed since the last request.
+    //
+    bool is_available() const;
+
+    // Function: total_energy
+    //
+    // Returns the sum of the component energies.
+    //
+    md::scalar total_energy() const;
+
+    // Function: names
+    //
+    // Returns the names of the components.
+    //
+    std::vector<std::string> const& names() const;
+
+    // Function: energies
+    //
+    // Returns the energies of the components.
+    //
+    std::vector<md::scalar> const& energies() const;
+
+private:
+    struct forcefield_component
+    {
+        md::index                       component;
+        std::shared_ptr<md::forcefield> forcefield;
+    };
+
+    std::vector<std::string>          _names;
+    std::vector<md::scalar>           _energies;
+    std::vector<forcefield_component> _forcefields;
+    bool                              _requested = false;
+    bool                              _available = false;
+};
+
+
+// Class: energy_monitor_forcefield
+//
+// Forcefield that exerts no force but completes the energy computation of an
+// energy_monitor in the requested force evaluation.
+//
+class energy_monitor_forcefield : public md::forcefield
+{
+public:
+    explicit energy_monitor_forcefield(std::shared_ptr<energy_monitor> monitor);
+
+    md::scalar compute_energy(md::system const& system) override;
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override;
+
+private:
+    std::shared_ptr<energy_monitor> _monitor;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+// This module defines mixed_softcore_potential, a fused evaluation of the
+// weighted sum of two softcore potentials used for A/B-mixed particles.
+
+#include <md.hpp>
+
+
+namespace detail
+{
+    template<int N>
+    inline md::scalar power(md::scalar x)
+    {
+        if constexpr (N == 0) {
+            return 1;
+        } else if constexpr (N % 2 == 0) {
+            auto const half = power<N / 2>(x);
+            return half * half;
+        } else {
+            return x * power<N - 1>(x);
+        }
+    }
+}
+
+
+// Struct: mixed_softcore_potential
+//
+// Equivalent to `a * md::softcore_potential<AP, AQ>{...} +
+// b * md::softcore_potential<BP, BQ>{...}`. The two terms share the squared
+// distance and a term with zero weight is skipped, which is the common case
+// for pure A or pure B particles. Each term is
+//
+//   u(r) = e (1 - (r/d)^p)^q   (r < d)
+//
+// where e is the weighted energy and d the diameter. P must be even.
+//
+template<int AP, int AQ, int BP, int BQ>
+struct mixed_softcore_potential
+{
+    static_assert(AP > 0 && AP % 2 == 0 && BP > 0 && BP % 2 == 0);
+    static_assert(AQ > 0 && BQ > 0);
+
+    md::scalar a_energy   = 0;
+    md::scalar a_diameter = 1;
+    md::scalar b_energy   = 0;
+    md::scalar b_diameter = 1;
+
+    md::scalar evaluate_energy(md::vector r) const
+    {
+        auto const r2 = r.squared_norm();
+        md::scalar energy = 0;
+
+        if (a_energy != 0) {
+            energy += term_energy<AP, AQ>(a_energy, a_diameter, r2);
+        }
+        if (b_energy != 0) {
+            energy += term_energy<BP, BQ>(b_energy, b_diameter, r2);
+        }
+        return energy;
+    }
+
+    md::vector evaluate_force(md::vector r) const
+    {
+        auto const r2 = r.squared_norm();
+        md::scalar coef = 0;
+
+        if (a_energy != 0) {
+            coef += term_force_coef<AP, AQ>(a_energy, a_diameter, r2);
+        }
+        if (b_energy != 0) {
+            coef += term_force_coef<BP, BQ>(b_energy, b_diameter, r2);
+        }
+        return coef * r;
+    }
+
+private:
+    template<int P, int Q>
+    static md::scalar term_energy(md::scalar e, md::scalar d, md::scalar r2)
+    {
+        auto const u2 = r2 / (d * d);
+        if (u2 >= 1) {
+            return 0;
+        }
+        return e * detail::power<Q>(1 - detail::power<P / 2>(u2));
+    }
+
+    // Returns F/r, i.e., -u'(r)/r = e p q (r/d)^(p-2) (1 - (r/d)^p)^(q-1) / d^2.
+    template<int P, int Q>
+    static md::scalar term_force_coef(md::scalar e, md::scalar d, md::scalar r2)
+    {
+        auto const k2 = 1 / (d * d);
+        auto const u2 = k2 * r2;
+        if (u2 >= 1) {
+            return 0;
+        }
+        auto const g = 1 - detail::power<P / 2>(u2);
+        return e * (P * Q) * k2 * detail::power<P / 2 - 1>(u2) * detail::power<Q - 1>(g);
+    }
+};
+
+
+// Function: mix_softcore_potentials
+//
+// Creates mixed_softcore_potential computing `a * a_potential + b * b_potential`.
+//
+template<int AP, int AQ, int BP, int BQ>
+mixed_softcore_potential<AP, AQ, BP, BQ> mix_softcore_potentials(
+    md::scalar a,
+    md::softcore_potential<AP, AQ> const& a_potential,
+    md::scalar b,
+    md::softcore_potential<BP, BQ> const& b_potential
+)
+{
+    return {
+        .a_energy   = a * a_potential.energy,
+        .a_diameter = a_potential.diameter,
+        .b_energy   = b * b_potential.energy,
+        .b_diameter = b_potential.diameter
+    };
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <md.hpp>
+
+#include "energy_monitor.hpp"
+#include "multiple_timestep_forcefield.hpp"
+#include "pair_list_forcefield.hpp"
+
+
+multiple_timestep_forcefield::multiple_timestep_forcefield(
+    std::shared_ptr<md::forcefield> inner
+)
+    : _forcefield{std::move(inner)}
+    , _pair_list_forcefield{dynamic_cast<pair_list_forcefield*>(_forcefield.get())}
+{
+}
+
+
+multiple_timestep_forcefield& multiple_timestep_forcefield::set_update_interval(
+    md::step interval
+)
+{
+    if (interval < 1) {
+        throw std::runtime_error("update interval must be positive");
+    }
+    _update_interval = interval;
+    invalidate();
+    return *this;
+}
+
+
+multiple_timestep_forcefield& multiple_timestep_forcefield::set_energy_monitor(
+    std::shared_ptr<energy_monitor> monitor, std::string const& name
+)
+{
+    if (monitor) {
+        _monitor_component = monitor->find_component(name);
+        _monitor = std::move(monitor);
+    }
+    return *this;
+}
+
+
+void multiple_timestep_forcefield::invalidate()
+{
+    _countdown = 0;
+}
+
+
+md::scalar multiple_timestep_forcefield::compute_energy(md::system const& system)
+{
+    // The next force evaluation updates the inner forcefield anyway unless
+    // the forces are held.
+    if (_countdown == 0) {
+        return _forcefield->compute_energy(system);
+    }
+    return compute_held_energy(system);
+}
+
+
+void multiple_timestep_forcefield::compute_force(
+    md::system const& system, md::array_view<md::vector> forces
+)
+{
+    if (_countdown == 0) {
+        _forces.resize(forces.size());
+        std::fill(_forces.begin(), _forces.end(), md::vector{});
+        _forcefield->compute_force(system, _forces);
+        _countdown = _update_interval;
+    } else if (_monitor && _monitor->is_requested()) {
+        _monitor->record(_monitor_component, compute_held_energy(system));
+    }
+    _countdown--;
+
+    for (md::index i = 0; i < forces.size(); i++) {
+        forces[i] += _forces[i];
+    }
+}
+
+
+md::scalar multiple_timestep_forcefield::compute_held_energy(md::system const& system)
+{
+    // Updating the neighbor list here could rebuild or reorder it at a step
+    // that depends on the logging and sampling intervals.
+    if (_pair_list_forcefield) {
+        return _pair_list_forcefield->compute_listed_energy(system);
+    }
+    return _forcefield->compute_energy(system);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// This module defines multiple_timestep_forcefield class, which evaluates an
+// expensive forcefield less frequently than the integration step.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <md.hpp>
+
+#include "energy_monitor.hpp"
+#include "pair_list_forcefield.hpp"
+
+
+// Class: multiple_timestep_forcefield
+//
+// Forcefield delegating to another forcefield every update_interval force
+// evaluations and reusing the forces of the last evaluation in between. This
+// splits the system into fast modes (bonds and walls, evaluated every step)
+// and slow modes (soft pair repulsions) in the manner of r-RESPA. Since the
+// dynamics is overdamped, the slow forces are held constant over the outer
+// step instead of being applied as an impulse.
+//
+// The first evaluation after construction, set_update_interval or invalidate
+// always delegates to the inner forcefield. Energies requested while the
+// forces are held do not update the neighbor list of a pair_list_forcefield,
+// so the forces do not depend on when energies are requested.
+//
+class multiple_timestep_forcefield : public md::forcefield
+{
+public:
+    explicit multiple_timestep_forcefield(std::shared_ptr<md::forcefield> inner);
+
+    // Function: set_update_interval
+    //
+    // Sets the number of force evaluations between evaluations of the inner
+    // forcefield. 1 evaluates the inner forcefield every time.
+    //
+    multiple_timestep_forcefield& set_update_interval(md::step interval);
+
+    // Function: set_energy_monitor
+    //
+    // Records the energy of the inner forcefield to the named component of
+    // monitor when the inner forcefield is not evaluated in a requested force
+    // evaluation. The inner forcefield records the energy itself otherwise.
+    //
+    multiple_timestep_forcefield& set_energy_monitor(
+        std::shared_ptr<energy_monitor> monitor, std::string const& name
+    );
+
+    // Function: invalidate
+    //
+    // Discards the held forces so that the next force evaluation delegates to
+    // the inner forcefield.
+    //
+    void invalidate();
+
+    md::scalar compute_energy(md::system const& system) override;
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override;
+
+private:
+    md::scalar compute_held_energy(md::system const& system);
+
+private:
+    std::shared_ptr<md::forcefield> _forcefield;
+    pair_list_forcefield*           _pair_list_forcefield = nullptr;
+    md::step                        _update_interval = 1;
+    md::step                        _countdown = 0;
+    std::vector<md::vector>         _forces;
+    std::shared_ptr<energy_monitor> _monitor;
+    md::index                       _monitor_component = 0;
+};
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "neighbor_pair_list.hpp"
+
+
+namespace
+{
+    // Function: spread_bits
+    //
+    // Inserts two zero bits between each of the lower 21 bits of x.
+    //
+    std::uint64_t spread_bits(std::uint64_t x)
+    {
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8) & 0x100f00f00f00f00f;
+        x = (x | x << 4) & 0x10c30c30c30c30c3;
+        x = (x | x << 2) & 0x1249249249249249;
+        return x;
+    }
+}
+
+
+void neighbor_pair_list::set_targets(std::vector<md::index> const& targets)
+{
+    _targets = targets;
+    _reference_points.clear();
+}
+
+
+void neighbor_pair_list::set_skin(md::scalar skin)
+{
+    _skin = skin;
+    _reference_points.clear();
+}
+
+
+void neighbor_pair_list::set_reorder_interval(md::index interval)
+{
+    _reorder_interval = interval;
+    _order.clear();
+    _ordered_pairs.clear();
+    _reference_points.clear();
+}
+
+
+void neighbor_pair_list::update(md::array_view<md::point const> points, md::scalar dcut)
+{
+    if (!is_valid(points, dcut)) {
+        rebuild(points, dcut);
+    }
+}
+
+
+void neighbor_pair_list::invalidate()
+{
+    _reference_points.clear();
+    _order.clear();
+}
+
+
+md::index neighbor_pair_list::rebuild_count() const
+{
+    return _rebuild_count;
+}
+
+
+bool neighbor_pair_list::is_valid(md::array_view<md::point const> points, md::scalar dcut) const
+{
+    if (_skin <= 0 || _reference_points.size() != points.size() || dcut > _list_dcut) {
+        return false;
+    }
+
+    // A pair within dcut now was within dcut + 2 * (max displacement) at the
+    // last rebuild. So the list is valid while every particle stays within
+    // half the margin from its reference position.
+    auto const max_displacement = (_list_dcut - dcut) / 2;
+    auto const max_displacement2 = max_displacement * max_displacement;
+
+    auto const is_close = [&](md::index i) {
+        return (points[i] - _reference_points[i]).squared_norm() <= max_displacement2;
+    };
+
+    if (_targets.empty()) {
+        for (md::index i = 0; i < points.size(); i++) {
+            if (!is_close(i)) {
+                return false;
+            }
+        }
+    } else {
+        for (auto const i : _targets) {
+            if (!is_close(i)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+void neighbor_pair_list::rebuild(md::array_view<md::point const> points, md::scalar dcut)
+{
+    _list_dcut = dcut + _skin;
+    _rebuild_count++;
+
+    if (_skin > 0) {
+        _reference_points.assign(points.begin(), points.end());
+    }
+
+    if (!_searcher || _list_dcut != _searcher_dcut) {
+        _searcher.emplace(md::open_box{}, _list_dcut);
+        _searcher_dcut = _list_dcut;
+    }
+
+    // Search pairs within the target points if given. Target-local indices
+    // are translated back to the particle indices in the output iterator.
+    md::array_view<md::index const> index_map;
+
+    if (_targets.empty()) {
+        _searcher->set_points(points);
+    } else {
+        _target_points.clear();
+        for (auto const i : _targets) {
+            _target_points.push_back(points[i]);
+        }
+        _searcher->set_points(_target_points);
+        index_map = _targets;
+    }
+
+    struct pair_output_iterator
+    {
+        std::vector<index_pair>&        output;
+        md::array_view<md::index const> index_map;
+
+        pair_output_iterator operator++(int)
+        {
+            return *this;
+        }
+
+        pair_output_iterator& operator*()
+        {
+            return *this;
+        }
+
+        void operator=(std::pair<md::index, md::index> const& pair)
+        {
+            auto i = pair.first;
+            auto j = pair.second;
+            if (index_map.size() > 0) {
+                i = index_map[i];
+                j = index_map[j];
+            }
+            output.push_back({std::min(i, j), std::max(i, j)});
+        }
+    };
+
+    _found_pairs.clear();
+    _searcher->search(pair_output_iterator{_found_pairs, index_map});
+
+    // Counting-sort the pairs by the first index. This is O(n) and stable, so
+    // the resulting order is deterministic.
+    _row_offsets.assign(points.size() + 1, 0);
+    for (auto const& pair : _found_pairs) {
+        _row_offsets[pair.i + 1]++;
+    }
+    for (md::index i = 0; i < points.size(); i++) {
+        _row_offsets[i + 1] += _row_offsets[i];
+    }
+
+    _pairs.resize(_found_pairs.size());
+    for (auto const& pair : _found_pairs) {
+        _pairs[_row_offsets[pair.i]++] = pair;
+    }
+
+    if (_reorder_interval > 0) {
+        if (_order.size() != points.size() || _rebuilds_since_reorder >= _reorder_interval) {
+            reorder(points);
+            _rebuilds_since_reorder = 0;
+        }
+        _rebuilds_since_reorder++;
+        rebuild_ordered_pairs();
+    }
+}
+
+
+void neighbor_pair_list::reorder(md::array_view<md::point const> points)
+{
+    // Particles are binned into cells of the list cutoff, and the cells are
+    // ordered along the Z-order curve. Each cell then neighbors mostly the
+    // cells close in the order.
+    md::point origin = points.size() > 0 ? points[0] : md::point{};
+    for (auto const& point : points) {
+        origin.x = std::min(origin.x, point.x);
+        origin.y = std::min(origin.y, point.y);
+        origin.z = std::min(origin.z, point.z);
+    }
+
+    auto const cell_size = _list_dcut > 0 ? _list_dcut : md::scalar(1);
+    auto const max_cell = md::scalar(0x1fffff);
+
+    auto const cell_coordinate = [&](md::scalar x) {
+        return static_cast<std::uint64_t>(std::min(std::floor(x / cell_size), max_cell));
+    };
+
+    _morton_codes.resize(points.size());
+    for (md::index i = 0; i < points.size(); i++) {
+        auto const r = points[i] - origin;
+        _morton_codes[i] =
+            spread_bits(cell_coordinate(r.x)) |
+            spread_bits(cell_coordinate(r.y)) << 1 |
+            spread_bits(cell_coordinate(r.z)) << 2;
+    }
+
+    // Ties are broken by the index, so the order is deterministic.
+    _order.resize(points.size());
+    for (md::index i = 0; i < points.size(); i++) {
+        _order[i] = i;
+    }
+    std::sort(_order.begin(), _order.end(), [&](md::index i, md::index j) {
+        return std::make_pair(_morton_codes[i], i) < std::make_pair(_morton_codes[j], j);
+    });
+
+    _ranks.resize(points.size());
+    for (md::index rank = 0; rank < _order.size(); rank++) {
+        _ranks[_order[rank]] = rank;
+    }
+}
+
+
+void neighbor_pair_list::rebuild_ordered_pairs()
+{
+    _found_pairs.clear();
+    for (auto const& pair : _pairs) {
+        auto const i = _ranks[pair.i];
+        auto const j = _ranks[pair.j];
+        _found_pairs.push_back({std::min(i, j), std::max(i, j)});
+    }
+
+    // Same counting sort as in rebuild.
+    _row_offsets.assign(_order.size() + 1, 0);
+    for (auto const& pair : _found_pairs) {
+        _row_offsets[pair.i + 1]++;
+    }
+    for (md::index i = 0; i < _order.size(); i++) {
+        _row_offsets[i + 1] += _row_offsets[i];
+    }
+
+    _ordered_pairs.resize(_found_pairs.size());
+    for (auto const& pair : _found_pairs) {
+        _ordered_pairs[_row_offsets[pair.i]++] = pair;
+    }
+}
+
+
+md::array_view<index_pair const> neighbor_pair_list::pairs() const
+{
+    return _pairs;
+}
+
+
+md::array_view<md::index const> neighbor_pair_list::order() const
+{
+    return _order;
+}
+
+
+md::array_view<index_pair const> neighbor_pair_list::ordered_pairs() const
+{
+    return _ordered_pairs;
+}
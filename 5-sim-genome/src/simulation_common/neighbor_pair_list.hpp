@@ -0,0 +1,130 @@
+#pragma once
+
+// This module defines neighbor_pair_list class, which enumerates pairs of
+// nearby particles in a canonical, deterministic order.
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <md.hpp>
+
+
+// Structure: index_pair
+//
+// Pair of particle indices.
+//
+struct index_pair
+{
+    md::index i = 0;
+    md::index j = 0;
+};
+
+
+// Class: neighbor_pair_list
+//
+// List of particle pairs within a cutoff distance. Pairs are stored with
+// i < j and sorted by i, so that the list can be split into per-particle
+// rows.
+//
+// With a positive skin the list works as a Verlet list: pairs are searched
+// within the cutoff plus skin, and the list is reused until some particle
+// moves far enough to possibly bring a new pair into the cutoff. Then the
+// list may contain pairs farther than the cutoff.
+//
+// Optionally the list also provides the pairs in a spatial order of the
+// particles, so that pair forces can be evaluated on a copy of the positions
+// in which nearby particles are close in memory. The particle indices seen
+// by the rest of the simulation do not change.
+//
+class neighbor_pair_list
+{
+public:
+    // Function: set_targets
+    //
+    // Restricts the search to the given particles. All particles are searched
+    // if targets are empty (the default).
+    //
+    void set_targets(std::vector<md::index> const& targets);
+
+    // Function: set_skin
+    //
+    // Sets the Verlet skin distance. Zero (the default) rebuilds the list on
+    // every update.
+    //
+    void set_skin(md::scalar skin);
+
+    // Function: set_reorder_interval
+    //
+    // Makes the list sort the particles by the Morton code of the grid cells
+    // containing them every given number of rebuilds. The pairs are also
+    // provided in terms of the sorted particles (see ordered_pairs). Zero
+    // (the default) disables the ordering.
+    //
+    void set_reorder_interval(md::index interval);
+
+    // Function: update
+    //
+    // Makes the list cover all pairs within the cutoff distance for given
+    // points. The list is rebuilt only if the current one may miss a pair.
+    //
+    void update(md::array_view<md::point const> points, md::scalar dcut);
+
+    // Function: invalidate
+    //
+    // Forces the next update to rebuild the list and to reorder the particles
+    // if the ordering is enabled.
+    //
+    void invalidate();
+
+    // Function: rebuild_count
+    //
+    // Returns the number of times the list has been rebuilt.
+    //
+    md::index rebuild_count() const;
+
+    // Function: pairs
+    //
+    // Returns the pairs found in the last update.
+    //
+    md::array_view<index_pair const> pairs() const;
+
+    // Function: order
+    //
+    // Returns the particle indices in the spatial order. Empty if the
+    // ordering is disabled.
+    //
+    md::array_view<md::index const> order() const;
+
+    // Function: ordered_pairs
+    //
+    // Returns the pairs found in the last update as the positions of the
+    // particles in order(). Pairs are stored with i < j and sorted by i.
+    //
+    md::array_view<index_pair const> ordered_pairs() const;
+
+private:
+    bool is_valid(md::array_view<md::point const> points, md::scalar dcut) const;
+    void rebuild(md::array_view<md::point const> points, md::scalar dcut);
+    void reorder(md::array_view<md::point const> points);
+    void rebuild_ordered_pairs();
+
+private:
+    md::scalar                                            _skin = 0;
+    md::scalar                                            _list_dcut = 0;
+    md::index                                             _rebuild_count = 0;
+    std::vector<md::point>                                _reference_points;
+    std::vector<md::index>                                _targets;
+    std::vector<md::point>                                _target_points;
+    std::optional<md::neighbor_searcher<md::open_box>>    _searcher;
+    md::scalar                                            _searcher_dcut = 0;
+    std::vector<index_pair>                               _found_pairs;
+    std::vector<index_pair>                               _pairs;
+    std::vector<md::index>                                _row_offsets;
+    md::index                                             _reorder_interval = 0;
+    md::index                                             _rebuilds_since_reorder = 0;
+    std::vector<md::index>                                _order;
+    std::vector<md::index>                                _ranks;
+    std::vector<std::uint64_t>                            _morton_codes;
+    std::vector<index_pair>                               _ordered_pairs;
+};
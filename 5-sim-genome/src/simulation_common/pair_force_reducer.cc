@@ -0,0 +1,65 @@
+#include <cassert>
+#include <vector>
+
+#include <md.hpp>
+
+#include "neighbor_pair_list.hpp"
+#include "pair_force_reducer.hpp"
+#include "worker_pool.hpp"
+
+
+void pair_force_reducer::set_pairs(
+    md::index particle_count, md::array_view<index_pair const> pairs
+)
+{
+    _first_offsets.assign(particle_count + 1, 0);
+    _second_offsets.assign(particle_count + 1, 0);
+
+    for (auto const& pair : pairs) {
+        _first_offsets[pair.i + 1]++;
+        _second_offsets[pair.j + 1]++;
+    }
+
+    for (md::index i = 0; i < particle_count; i++) {
+        _first_offsets[i + 1] += _first_offsets[i];
+        _second_offsets[i + 1] += _second_offsets[i];
+    }
+
+    // Pairs are sorted by the first index, so the pairs sharing the first
+    // index are contiguous. The second index needs an explicit list.
+    _second_pairs.resize(pairs.size());
+
+    _cursors.assign(_second_offsets.begin(), _second_offsets.end());
+    for (md::index k = 0; k < pairs.size(); k++) {
+        assert(k == 0 || pairs[k - 1].i <= pairs[k].i);
+        _second_pairs[_cursors[pairs[k].j]++] = k;
+    }
+}
+
+
+void pair_force_reducer::reduce(
+    worker_pool&                      workers,
+    md::array_view<md::vector const>  pair_forces,
+    md::array_view<md::vector>        forces
+) const
+{
+    auto const particle_count = _first_offsets.size() - 1;
+
+    workers.run([&](md::index worker) {
+        auto const [begin, end] = workers.partition(particle_count, worker);
+
+        for (md::index i = begin; i < end; i++) {
+            md::vector force;
+
+            for (auto k = _first_offsets[i]; k < _first_offsets[i + 1]; k++) {
+                force += pair_forces[k];
+            }
+
+            for (auto k = _second_offsets[i]; k < _second_offsets[i + 1]; k++) {
+                force -= pair_forces[_second_pairs[k]];
+            }
+
+            forces[i] += force;
+        }
+    });
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// This module defines pair_force_reducer class, which sums up pairwise forces
+// computed in parallel into per-particle forces in a deterministic order.
+
+#include <vector>
+
+#include <md.hpp>
+
+#include "neighbor_pair_list.hpp"
+#include "worker_pool.hpp"
+
+
+// Class: pair_force_reducer
+//
+// Workers write the force of each pair into their own slice of a per-pair
+// force buffer. This class then gathers the buffer into per-particle forces,
+// visiting the pairs of each particle in a fixed order. So the result does
+// not depend on how the pairs are split across workers.
+//
+class pair_force_reducer
+{
+public:
+    // Function: set_pairs
+    //
+    // Indexes pairs by particles. The pairs must be sorted by the first index.
+    //
+    void set_pairs(md::index particle_count, md::array_view<index_pair const> pairs);
+
+    // Function: reduce
+    //
+    // Adds pair_forces[k] to forces[pairs[k].i] and subtracts it from
+    // forces[pairs[k].j] for all k.
+    //
+    void reduce(
+        worker_pool&                      workers,
+        md::array_view<md::vector const>  pair_forces,
+        md::array_view<md::vector>        forces
+    ) const;
+
+private:
+    std::vector<md::index> _first_offsets;
+    std::vector<md::index> _second_offsets;
+    std::vector<md::index> _second_pairs;
+    std::vector<md::index> _cursors;
+};
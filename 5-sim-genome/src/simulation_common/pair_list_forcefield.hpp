@@ -0,0 +1,28 @@
+#pragma once
+
+// This module defines pair_list_forcefield interface, which lets a caller
+// evaluate the energy of a forcefield without updating its neighbor list.
+
+#include <md.hpp>
+
+
+// Class: pair_list_forcefield
+//
+// Forcefield computing interactions over a neighbor list that it updates in
+// compute_energy and compute_force. Updating the list changes when it is
+// rebuilt and reordered, which in turn affects the forces bitwise. So a
+// caller that only needs the energy, e.g. multiple_timestep_forcefield on a
+// step where the forces are held, uses compute_listed_energy instead.
+//
+class pair_list_forcefield : public md::forcefield
+{
+public:
+    // Function: compute_listed_energy
+    //
+    // Returns the energy of the pairs in the current neighbor list without
+    // updating the list. Pairs that have come into range since the last
+    // update are missed, so the value is exact only as long as the list is
+    // within its skin.
+    //
+    virtual md::scalar compute_listed_energy(md::system const& system) = 0;
+};
@@ -0,0 +1,684 @@
+#pragma once
+
+// This module defines pairwise forcefields evaluated by a worker_pool. Each
+// worker computes the forces of a contiguous share of the pairs into its own
+// slice of a per-pair buffer, and the buffer is then reduced per particle in a
+// fixed order (see pair_force_reducer). So simulations stay bit-reproducible
+// for a given seed and number of workers. The pair loop is compiled for each
+// simd_level and the level is selected at run time. Wider levels evaluate
+// potentials supported by softcore_block_evaluator in blocks of pairs.
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "energy_monitor.hpp"
+#include "neighbor_pair_list.hpp"
+#include "pair_force_reducer.hpp"
+#include "pair_list_forcefield.hpp"
+#include "simd_level.hpp"
+#include "simd_softcore_block.hpp"
+#include "worker_pool.hpp"
+
+
+// Struct: has_ordered_lookup
+//
+// True if PotFn, besides (i, j) -> potential, has set_order(order) and
+// ordered(k, l) returning the potential of particles order[k] and order[l].
+// Such a function can gather its per-particle data into the order so that
+// pairs in the order do not look up the data scattered in particle order.
+//
+template<typename PotFn, typename = void>
+struct has_ordered_lookup : std::false_type
+{
+};
+
+template<typename PotFn>
+struct has_ordered_lookup<
+    PotFn,
+    std::void_t<
+        decltype(std::declval<PotFn&>().set_order(std::declval<md::array_view<md::index const>>())),
+        decltype(std::declval<PotFn const&>().ordered(md::index{}, md::index{}))
+    >
+> : std::true_type
+{
+};
+
+
+// Class: parallel_pair_kernel
+//
+// Evaluates potential energy and forces of given pairs in parallel. PotFn is a
+// function (i, j) -> potential, optionally with ordered lookup (see
+// has_ordered_lookup).
+//
+template<typename PotFn>
+class parallel_pair_kernel
+{
+public:
+    parallel_pair_kernel(std::shared_ptr<worker_pool> workers, PotFn potential)
+        : _workers{std::move(workers)}
+        , _potential{std::move(potential)}
+    {
+    }
+
+    // Function: set_simd_level
+    //
+    // Sets the instruction set used by the pair loop. Default is sse.
+    //
+    void set_simd_level(simd_level level)
+    {
+        _simd_level = level;
+    }
+
+    // Function: set_order
+    //
+    // Passes the order used by subsequent compute_ordered_* calls to the
+    // potential function if it supports ordered lookup. The potential is
+    // looked up by particle indices through order otherwise.
+    //
+    void set_order(md::array_view<md::index const> order)
+    {
+        if constexpr (has_ordered_lookup<PotFn>::value) {
+            _potential.set_order(order);
+        }
+    }
+
+    // Function: compute_energy
+    //
+    // Returns the sum of the potential energy of the pairs.
+    //
+    md::scalar compute_energy(
+        md::system const&                system,
+        md::array_view<index_pair const> pairs
+    )
+    {
+        auto const positions = system.view_positions();
+
+        _partial_energies.assign(_workers->size(), 0);
+
+        _workers->run([&](md::index worker) {
+            auto const range = _workers->partition(pairs.size(), worker);
+            _partial_energies[worker] = evaluate_range<false, true>(positions, {}, pairs, range);
+        });
+
+        return std::accumulate(_partial_energies.begin(), _partial_energies.end(), md::scalar(0));
+    }
+
+    // Function: compute_force
+    //
+    // Adds the forces of the pairs to forces. The reducer must be indexed
+    // with the same pairs.
+    //
+    void compute_force(
+        md::system const&                system,
+        md::array_view<index_pair const> pairs,
+        pair_force_reducer const&        reducer,
+        md::array_view<md::vector>       forces
+    )
+    {
+        evaluate<false>(system.view_positions(), {}, pairs, reducer, forces);
+    }
+
+    // Function: compute_force_and_energy
+    //
+    // Same as compute_force but also returns the sum of the potential energy
+    // of the pairs, computed in the same pass.
+    //
+    md::scalar compute_force_and_energy(
+        md::system const&                system,
+        md::array_view<index_pair const> pairs,
+        pair_force_reducer const&        reducer,
+        md::array_view<md::vector>       forces
+    )
+    {
+        return evaluate<true>(system.view_positions(), {}, pairs, reducer, forces);
+    }
+
+    // Function: compute_ordered_force
+    //
+    // Same as compute_force but for particles laid out in another order.
+    // positions, pairs, the reducer and forces are indexed by the place in the
+    // order, and order maps the places to the particle indices passed to the
+    // potential function. order must be the one last passed to set_order.
+    //
+    void compute_ordered_force(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        pair_force_reducer const&        reducer,
+        md::array_view<md::vector>       forces
+    )
+    {
+        evaluate<false>(positions, order, pairs, reducer, forces);
+    }
+
+    // Function: compute_ordered_force_and_energy
+    //
+    // Same as compute_ordered_force but also returns the sum of the potential
+    // energy of the pairs.
+    //
+    md::scalar compute_ordered_force_and_energy(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        pair_force_reducer const&        reducer,
+        md::array_view<md::vector>       forces
+    )
+    {
+        return evaluate<true>(positions, order, pairs, reducer, forces);
+    }
+
+private:
+    using potential_type = std::decay_t<std::invoke_result_t<PotFn&, md::index, md::index>>;
+
+    // Returns the potential of the pair at places i and j in order, or of
+    // particles i and j if order is empty.
+    SIMD_INLINE decltype(auto) pair_potential(
+        md::array_view<md::index const> order, md::index i, md::index j
+    ) const
+    {
+        if (order.size() == 0) {
+            return _potential(i, j);
+        }
+        if constexpr (has_ordered_lookup<PotFn>::value) {
+            return _potential.ordered(i, j);
+        } else {
+            return _potential(order[i], order[j]);
+        }
+    }
+
+    template<bool with_energy>
+    md::scalar evaluate(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        pair_force_reducer const&        reducer,
+        md::array_view<md::vector>       forces
+    )
+    {
+        _pair_forces.resize(pairs.size());
+        _partial_energies.assign(_workers->size(), 0);
+
+        _workers->run([&](md::index worker) {
+            auto const range = _workers->partition(pairs.size(), worker);
+            _partial_energies[worker] = evaluate_range<true, with_energy>(
+                positions, order, pairs, range
+            );
+        });
+
+        reducer.reduce(*_workers, _pair_forces, forces);
+
+        return std::accumulate(_partial_energies.begin(), _partial_energies.end(), md::scalar(0));
+    }
+
+    // Evaluates the pairs in range with the selected instruction set. Forces
+    // are stored to _pair_forces and the sum of the energy is returned. Pair
+    // indices are mapped through order unless it is empty.
+    template<bool with_force, bool with_energy>
+    md::scalar evaluate_range(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        std::pair<md::index, md::index>  range
+    )
+    {
+        switch (_simd_level) {
+        case simd_level::avx512:
+            return evaluate_range_avx512<with_force, with_energy>(positions, order, pairs, range);
+        case simd_level::avx2:
+            return evaluate_range_avx2<with_force, with_energy>(positions, order, pairs, range);
+        case simd_level::sse:
+            break;
+        }
+        return evaluate_range_body<with_force, with_energy>(positions, order, pairs, range);
+    }
+
+    template<bool with_force, bool with_energy>
+    SIMD_TARGET_AVX2
+    md::scalar evaluate_range_avx2(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        std::pair<md::index, md::index>  range
+    )
+    {
+        if constexpr (is_simd_pair_potential<potential_type>::value) {
+            return evaluate_range_blocks<4, with_force, with_energy>(
+                positions, order, pairs, range
+            );
+        } else {
+            return evaluate_range_body<with_force, with_energy>(positions, order, pairs, range);
+        }
+    }
+
+    template<bool with_force, bool with_energy>
+    SIMD_TARGET_AVX512
+    md::scalar evaluate_range_avx512(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        std::pair<md::index, md::index>  range
+    )
+    {
+        if constexpr (is_simd_pair_potential<potential_type>::value) {
+            return evaluate_range_blocks<8, with_force, with_energy>(
+                positions, order, pairs, range
+            );
+        } else {
+            return evaluate_range_body<with_force, with_energy>(positions, order, pairs, range);
+        }
+    }
+
+    // Evaluates the pairs in range in blocks of W pairs, one pair per vector
+    // lane. Displacements and potential parameters are gathered into the
+    // lanes and the remainder of the range is left to the scalar loop.
+    template<int W, bool with_force, bool with_energy>
+    SIMD_INLINE
+    md::scalar evaluate_range_blocks(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        std::pair<md::index, md::index>  range
+    )
+    {
+        using evaluator = softcore_block_evaluator<potential_type>;
+
+        detail::simd_vec<W> energies = {};
+        auto k = range.first;
+
+        for (; k + W <= range.second; k += W) {
+            detail::softcore_block<W> block;
+
+            for (int lane = 0; lane < W; lane++) {
+                auto const i = pairs[k + md::index(lane)].i;
+                auto const j = pairs[k + md::index(lane)].j;
+                auto const r = positions[i] - positions[j];
+                auto const& potential = pair_potential(order, i, j);
+
+                block.dx[lane] = r.x;
+                block.dy[lane] = r.y;
+                block.dz[lane] = r.z;
+                evaluator::load(block, lane, potential);
+            }
+            block.r2 = block.dx * block.dx + block.dy * block.dy + block.dz * block.dz;
+
+            detail::simd_vec<W> coef;
+            detail::simd_vec<W> block_energies;
+            evaluator::template evaluate<with_force, with_energy, W>(block, coef, block_energies);
+
+            if constexpr (with_force) {
+                for (int lane = 0; lane < W; lane++) {
+                    _pair_forces[k + md::index(lane)] = {
+                        coef[lane] * block.dx[lane],
+                        coef[lane] * block.dy[lane],
+                        coef[lane] * block.dz[lane],
+                    };
+                }
+            }
+
+            if constexpr (with_energy) {
+                energies += block_energies;
+            }
+        }
+
+        md::scalar energy = 0;
+        for (int lane = 0; lane < W; lane++) {
+            energy += energies[lane];
+        }
+        return energy + evaluate_range_body<with_force, with_energy>(
+            positions, order, pairs, {k, range.second}
+        );
+    }
+
+    template<bool with_force, bool with_energy>
+    SIMD_INLINE
+    md::scalar evaluate_range_body(
+        md::array_view<md::point const>  positions,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        std::pair<md::index, md::index>  range
+    )
+    {
+        md::scalar energy = 0;
+
+        for (auto k = range.first; k < range.second; k++) {
+            auto const i = pairs[k].i;
+            auto const j = pairs[k].j;
+            auto const r = positions[i] - positions[j];
+            auto const& potential = pair_potential(order, i, j);
+
+            if constexpr (with_force) {
+                _pair_forces[k] = potential.evaluate_force(r);
+            }
+
+            if constexpr (with_energy) {
+                energy += potential.evaluate_energy(r);
+            }
+        }
+
+        return energy;
+    }
+
+private:
+    std::shared_ptr<worker_pool> _workers;
+    PotFn                        _potential;
+    simd_level                   _simd_level = simd_level::sse;
+    std::vector<md::vector>      _pair_forces;
+    std::vector<md::scalar>      _partial_energies;
+};
+
+
+// Class: parallel_bonded_pairwise_forcefield
+//
+// Parallel counterpart of md::bonded_pairwise_forcefield.
+//
+template<typename PotFn>
+class parallel_bonded_pairwise_forcefield : public md::forcefield
+{
+public:
+    parallel_bonded_pairwise_forcefield(std::shared_ptr<worker_pool> workers, PotFn potential)
+        : _kernel{std::move(workers), std::move(potential)}
+    {
+    }
+
+    // Function: add_bonded_pair
+    //
+    // Adds a bond between particles i and j.
+    //
+    parallel_bonded_pairwise_forcefield& add_bonded_pair(md::index i, md::index j)
+    {
+        _pairs.push_back({std::min(i, j), std::max(i, j)});
+        _indexed = false;
+        return *this;
+    }
+
+    // Function: add_bonded_range
+    //
+    // Adds bonds between adjacent particles in the index range [begin, end).
+    //
+    parallel_bonded_pairwise_forcefield& add_bonded_range(md::index begin, md::index end)
+    {
+        for (auto i = begin; i + 1 < end; i++) {
+            add_bonded_pair(i, i + 1);
+        }
+        return *this;
+    }
+
+    md::scalar compute_energy(md::system const& system) override
+    {
+        return _kernel.compute_energy(system, _pairs);
+    }
+
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override
+    {
+        if (!_indexed) {
+            std::stable_sort(
+                _pairs.begin(),
+                _pairs.end(),
+                [](index_pair const& p, index_pair const& q) { return p.i < q.i; }
+            );
+            _reducer.set_pairs(system.particle_count(), _pairs);
+            _indexed = true;
+        }
+
+        if (_monitor && _monitor->is_requested()) {
+            auto const energy = _kernel.compute_force_and_energy(system, _pairs, _reducer, forces);
+            _monitor->record(_monitor_component, energy);
+        } else {
+            _kernel.compute_force(system, _pairs, _reducer, forces);
+        }
+    }
+
+    // Function: set_simd_level
+    //
+    // Sets the instruction set used to evaluate the pairs. See simd_level.
+    //
+    parallel_bonded_pairwise_forcefield& set_simd_level(simd_level level)
+    {
+        _kernel.set_simd_level(level);
+        return *this;
+    }
+
+    // Function: set_energy_monitor
+    //
+    // Makes the forcefield record its energy to a new component of monitor
+    // when the monitor requests energies. Null monitor is ignored.
+    //
+    parallel_bonded_pairwise_forcefield& set_energy_monitor(
+        std::shared_ptr<energy_monitor> monitor, std::string const& name
+    )
+    {
+        if (monitor) {
+            _monitor_component = monitor->add_component(name);
+            _monitor = std::move(monitor);
+        }
+        return *this;
+    }
+
+private:
+    parallel_pair_kernel<PotFn>     _kernel;
+    std::vector<index_pair>         _pairs;
+    pair_force_reducer              _reducer;
+    bool                            _indexed = false;
+    std::shared_ptr<energy_monitor> _monitor;
+    md::index                       _monitor_component = 0;
+};
+
+
+// Class: parallel_neighbor_pairwise_forcefield
+//
+// Parallel counterpart of md::neighbor_pairwise_forcefield.
+//
+template<typename PotFn>
+class parallel_neighbor_pairwise_forcefield : public pair_list_forcefield
+{
+public:
+    parallel_neighbor_pairwise_forcefield(std::shared_ptr<worker_pool> workers, PotFn potential)
+        : _kernel{std::move(workers), std::move(potential)}
+    {
+    }
+
+    // Function: set_neighbor_distance
+    //
+    // Sets the cutoff distance of the neighbor search. The distance may be a
+    // scalar or a function returning a scalar.
+    //
+    parallel_neighbor_pairwise_forcefield& set_neighbor_distance(md::scalar dcut)
+    {
+        _neighbor_distance = [=] { return dcut; };
+        return *this;
+    }
+
+    parallel_neighbor_pairwise_forcefield& set_neighbor_distance(std::function<md::scalar()> dcut)
+    {
+        _neighbor_distance = std::move(dcut);
+        return *this;
+    }
+
+    // Function: set_neighbor_targets
+    //
+    // Restricts interactions to the pairs among the given particles.
+    //
+    parallel_neighbor_pairwise_forcefield& set_neighbor_targets(std::vector<md::index> const& targets)
+    {
+        _pair_list->set_targets(targets);
+        return *this;
+    }
+
+    // Function: set_neighbor_skin
+    //
+    // Sets the Verlet skin of the neighbor list. See neighbor_pair_list.
+    //
+    parallel_neighbor_pairwise_forcefield& set_neighbor_skin(md::scalar skin)
+    {
+        _pair_list->set_skin(skin);
+        return *this;
+    }
+
+    // Function: set_neighbor_list
+    //
+    // Uses given pair list instead of the forcefield's own one. The list is
+    // updated by this forcefield and can be read by others, e.g. for finding
+    // contacts, as long as the neighbor distance covers their cutoff.
+    //
+    parallel_neighbor_pairwise_forcefield& set_neighbor_list(std::shared_ptr<neighbor_pair_list> pair_list)
+    {
+        _pair_list = std::move(pair_list);
+        return *this;
+    }
+
+    md::scalar compute_energy(md::system const& system) override
+    {
+        _pair_list->update(system.view_positions(), _neighbor_distance());
+        return _kernel.compute_energy(system, _pair_list->pairs());
+    }
+
+    md::scalar compute_listed_energy(md::system const& system) override
+    {
+        return _kernel.compute_energy(system, _pair_list->pairs());
+    }
+
+    void compute_force(md::system const& system, md::array_view<md::vector> forces) override
+    {
+        _pair_list->update(system.view_positions(), _neighbor_distance());
+
+        auto const order = _pair_list->order();
+        auto const pairs = order.size() > 0 ? _pair_list->ordered_pairs() : _pair_list->pairs();
+
+        // The reducer needs re-indexing, and the potential function the new
+        // order, only when the list is rebuilt.
+        if (_pair_list->rebuild_count() != _indexed_revision) {
+            _reducer.set_pairs(system.particle_count(), pairs);
+            _kernel.set_order(order);
+            _indexed_revision = _pair_list->rebuild_count();
+        }
+
+        if (order.size() > 0) {
+            compute_ordered_force(system, order, pairs, forces);
+            return;
+        }
+
+        if (_monitor && _monitor->is_requested()) {
+            auto const energy = _kernel.compute_force_and_energy(
+                system, _pair_list->pairs(), _reducer, forces
+            );
+            _monitor->record(_monitor_component, energy);
+        } else {
+            _kernel.compute_force(system, _pair_list->pairs(), _reducer, forces);
+        }
+    }
+
+    // Function: set_simd_level
+    //
+    // Sets the instruction set used to evaluate the pairs. See simd_level.
+    //
+    parallel_neighbor_pairwise_forcefield& set_simd_level(simd_level level)
+    {
+        _kernel.set_simd_level(level);
+        return *this;
+    }
+
+    // Function: set_energy_monitor
+    //
+    // Makes the forcefield record its energy to a new component of monitor
+    // when the monitor requests energies. Null monitor is ignored.
+    //
+    parallel_neighbor_pairwise_forcefield& set_energy_monitor(
+        std::shared_ptr<energy_monitor> monitor, std::string const& name
+    )
+    {
+        if (monitor) {
+            _monitor_component = monitor->add_component(name);
+            _monitor = std::move(monitor);
+        }
+        return *this;
+    }
+
+    // Function: rebuild_count
+    //
+    // Returns the number of times the neighbor list has been rebuilt.
+    //
+    md::index rebuild_count() const
+    {
+        return _pair_list->rebuild_count();
+    }
+
+private:
+    // Evaluates the pairs on a copy of the positions in the spatial order of
+    // the pair list and scatters the forces back to the particles.
+    void compute_ordered_force(
+        md::system const&                system,
+        md::array_view<md::index const>  order,
+        md::array_view<index_pair const> pairs,
+        md::array_view<md::vector>       forces
+    )
+    {
+        auto const positions = system.view_positions();
+
+        _ordered_positions.resize(order.size());
+        for (md::index k = 0; k < order.size(); k++) {
+            _ordered_positions[k] = positions[order[k]];
+        }
+        _ordered_forces.assign(order.size(), md::vector{});
+
+        if (_monitor && _monitor->is_requested()) {
+            auto const energy = _kernel.compute_ordered_force_and_energy(
+                _ordered_positions, order, pairs, _reducer, _ordered_forces
+            );
+            _monitor->record(_monitor_component, energy);
+        } else {
+            _kernel.compute_ordered_force(
+                _ordered_positions, order, pairs, _reducer, _ordered_forces
+            );
+        }
+
+        for (md::index k = 0; k < order.size(); k++) {
+            forces[order[k]] += _ordered_forces[k];
+        }
+    }
+
+private:
+    parallel_pair_kernel<PotFn>         _kernel;
+    std::function<md::scalar()>         _neighbor_distance = [] { return md::scalar(0); };
+    std::shared_ptr<neighbor_pair_list> _pair_list = std::make_shared<neighbor_pair_list>();
+    pair_force_reducer                  _reducer;
+    md::index                           _indexed_revision = 0;
+    std::shared_ptr<energy_monitor>     _monitor;
+    md::index                           _monitor_component = 0;
+    std::vector<md::point>              _ordered_positions;
+    std::vector<md::vector>             _ordered_forces;
+};
+
+
+// Function: make_parallel_bonded_pairwise_forcefield
+//
+// Creates a parallel_bonded_pairwise_forcefield with given potential function.
+//
+template<typename PotFn>
+parallel_bonded_pairwise_forcefield<PotFn> make_parallel_bonded_pairwise_forcefield(
+    std::shared_ptr<worker_pool> workers, PotFn potential
+)
+{
+    return {std::move(workers), std::move(potential)};
+}
+
+
+// Function: make_parallel_neighbor_pairwise_forcefield
+//
+// Creates a parallel_neighbor_pairwise_forcefield with given potential
+// function.
+//
+template<typename PotFn>
+parallel_neighbor_pairwise_forcefield<PotFn> make_parallel_neighbor_pairwise_forcefield(
+    std::shared_ptr<worker_pool> workers, PotFn potential
+)
+{
+    return {std::move(workers), std::move(potential)};
+}
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <md.hpp>
+
+#include "position_codec.hpp"
+
+
+namespace
+{
+    // Fixed-point coordinates are limited to this magnitude so that the
+    // difference of two coordinates fits in int32.
+    constexpr float max_fixed_point = float(1 << 30);
+
+    std::uint32_t zigzag(std::int32_t value)
+    {
+        return (std::uint32_t(value) << 1) ^ std::uint32_t(value >> 31);
+    }
+
+    std::int32_t unzigzag(std::uint32_t value)
+    {
+        return std::int32_t(value >> 1) ^ -std::int32_t(value & 1);
+    }
+
+    int bit_width(std::uint32_t value)
+    {
+        int width = 0;
+        for (; value != 0; value >>= 1) {
+            width++;
+        }
+        return width;
+    }
+
+
+    class bit_writer
+    {
+    public:
+        explicit bit_writer(std::vector<std::uint8_t>& output)
+            : _output{output}
+        {
+        }
+
+        void write(std::uint32_t value, int width)
+        {
+            _buffer |= std::uint64_t(value) << _buffer_bits;
+            _buffer_bits += width;
+
+            for (; _buffer_bits >= 8; _buffer_bits -= 8) {
+                _output.push_back(static_cast<std::uint8_t>(_buffer));
+                _buffer >>= 8;
+            }
+        }
+
+        void flush()
+        {
+            if (_buffer_bits > 0) {
+                _output.push_back(static_cast<std::uint8_t>(_buffer));
+            }
+            _buffer = 0;
+            _buffer_bits = 0;
+        }
+
+    private:
+        std::vector<std::uint8_t>& _output;
+        std::uint64_t              _buffer = 0;
+        int                        _buffer_bits = 0;
+    };
+
+
+    class bit_reader
+    {
+    public:
+        explicit bit_reader(std::vector<std::uint8_t> const& input)
+            : _input{input}
+        {
+        }
+
+        std::uint32_t read(int width)
+        {
+            for (; _buffer_bits < width; _buffer_bits += 8) {
+                if (_position == _input.size()) {
+                    throw std::runtime_error("truncated packed positions");
+                }
+                _buffer |= std::uint64_t(_input[_position++]) << _buffer_bits;
+            }
+
+            auto const value = static_cast<std::uint32_t>(_buffer & ((std::uint64_t(1) << width) - 1));
+            _buffer >>= width;
+            _buffer_bits -= width;
+            return value;
+        }
+
+    private:
+        std::vector<std::uint8_t> const& _input;
+        std::size_t                      _position = 0;
+        std::uint64_t                    _buffer = 0;
+        int                              _buffer_bits = 0;
+    };
+}
+
+
+bool encode_packed_positions(
+    md::array_view<md::point const> positions, int fraction_bits, packed_positions& packed
+)
+{
+    float const scale = float(1 << fraction_bits);
+
+    // Residuals from the previous particle, zigzag-encoded.
+    std::vector<std::uint32_t> values;
+    values.reserve(positions.size() * 3);
+
+    std::array<std::int32_t, 3> prev = {0, 0, 0};
+
+    for (auto const& pos : positions) {
+        std::array<std::int32_t, 3> fixed;
+        std::array<md::scalar, 3> const coords = {pos.x, pos.y, pos.z};
+
+        for (std::size_t axis = 0; axis < 3; axis++) {
+            auto const scaled = std::nearbyint(float(coords[axis]) * scale);
+            if (!(std::fabs(scaled) < max_fixed_point)) {
+                return false;
+            }
+            fixed[axis] = static_cast<std::int32_t>(scaled);
+            values.push_back(zigzag(fixed[axis] - prev[axis]));
+        }
+        prev = fixed;
+    }
+
+    packed.point_count = positions.size();
+    packed.fraction_bits = fraction_bits;
+    packed.widths.clear();
+    packed.payload.clear();
+
+    bit_writer writer{packed.payload};
+
+    for (std::size_t start = 0; start < values.size(); start += packed_positions_block_size) {
+        auto const end = std::min(start + packed_positions_block_size, values.size());
+
+        std::uint32_t bits = 0;
+        for (auto k = start; k < end; k++) {
+            bits |= values[k];
+        }
+        auto const width = bit_width(bits);
+        packed.widths.push_back(static_cast<std::uint8_t>(width));
+
+        for (auto k = start; k < end; k++) {
+            writer.write(values[k], width);
+        }
+    }
+    writer.flush();
+
+    return true;
+}
+
+
+std::vector<md::point> decode_packed_positions(packed_positions const& packed)
+{
+    auto const value_count = packed.point_count * 3;
+    auto const block_count =
+        (value_count + packed_positions_block_size - 1) / packed_positions_block_size;
+
+    if (packed.widths.size() != block_count) {
+        throw std::runtime_error("inconsistent packed positions");
+    }
+
+    bit_reader reader{packed.payload};
+    auto const scale = std::ldexp(md::scalar(1), -packed.fraction_bits);
+
+    std::vector<md::point> positions;
+    positions.reserve(packed.point_count);
+
+    std::array<std::int32_t, 3> fixed = {0, 0, 0};
+    std::size_t value_index = 0;
+
+    for (std::uint64_t i = 0; i < packed.point_count; i++) {
+        for (std::size_t axis = 0; axis < 3; axis++, value_index++) {
+            int const width = packed.widths[value_index / packed_positions_block_size];
+            if (width > 32) {
+                throw std::runtime_error("inconsistent packed positions");
+            }
+            // Unsigned addition keeps corrupt data from overflowing.
+            fixed[axis] = static_cast<std::int32_t>(
+                std::uint32_t(fixed[axis]) + std::uint32_t(unzigzag(reader.read(width)))
+            );
+        }
+
+        positions.push_back({
+            fixed[0] * scale,
+            fixed[1] * scale,
+            fixed[2] * scale
+        });
+    }
+
+    return positions;
+}
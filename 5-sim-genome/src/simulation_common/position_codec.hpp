@@ -0,0 +1,55 @@
+#pragma once
+
+// This module defines a lossless codec of quantized particle positions saved
+// in trajectory files. Coordinates are converted to fixed-point integers and
+// each particle is predicted from the previous one, which is its neighbor on
+// the polymer chain. The residuals are bit-packed in blocks of adaptive bit
+// width, so small residuals take only a few bits each.
+
+#include <cstdint>
+#include <vector>
+
+#include <md.hpp>
+
+
+// Struct: packed_positions
+//
+// Encoded positions. The residuals of the x, y and z coordinates of the
+// particles are zigzag-encoded into unsigned integers, interleaved and split
+// into blocks of packed_positions_block_size values. Values of a block take
+// widths[block] bits each in payload, in the little-endian bit order.
+//
+struct packed_positions
+{
+    std::uint64_t             point_count = 0;
+    int                       fraction_bits = 0;
+    std::vector<std::uint8_t> widths;
+    std::vector<std::uint8_t> payload;
+};
+
+
+// Constant: packed_positions_block_size
+//
+// Number of values sharing a bit width.
+//
+constexpr std::size_t packed_positions_block_size = 64;
+
+
+// Function: encode_packed_positions
+//
+// Quantizes positions to the given number of fraction bits and encodes them.
+// The quantization is the same as rounding float32 coordinates to multiples
+// of 2^-fraction_bits. Returns false if some coordinate is not finite or too
+// large to represent.
+//
+bool encode_packed_positions(
+    md::array_view<md::point const> positions, int fraction_bits, packed_positions& packed
+);
+
+
+// Function: decode_packed_positions
+//
+// Decodes positions encoded by encode_packed_positions. Throws
+// std::runtime_error if the data is inconsistent.
+//
+std::vector<md::point> decode_packed_positions(packed_positions const& packed);
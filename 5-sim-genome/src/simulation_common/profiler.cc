@@ -0,0 +1,118 @@
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <md.hpp>
+
+#include "profiler.hpp"
+
+
+namespace
+{
+    double to_seconds(profiler::clock::duration duration)
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    bool ends_with(std::string const& str, std::string const& suffix)
+    {
+        return str.size() >= suffix.size()
+            && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+
+md::index profiler::section(std::string const& name)
+{
+    for (md::index i = 0; i < _sections.size(); i++) {
+        if (_sections[i].name == name) {
+            return i;
+        }
+    }
+    _sections.push_back({.name = name});
+    return _sections.size() - 1;
+}
+
+
+void profiler::record(md::index section, clock::duration elapsed)
+{
+    auto& stats = _sections[section];
+    stats.calls++;
+    stats.time += elapsed;
+}
+
+
+void profiler::count(std::string const& name, md::step n)
+{
+    counter(name) += n;
+}
+
+
+void profiler::set_count(std::string const& name, md::step value)
+{
+    counter(name) = value;
+}
+
+
+md::step& profiler::counter(std::string const& name)
+{
+    for (auto& [counter_name, value] : _counters) {
+        if (counter_name == name) {
+            return value;
+        }
+    }
+    return _counters.emplace_back(name, 0).second;
+}
+
+
+std::string profiler::format_json() const
+{
+    auto sections = nlohmann::json::array();
+    for (auto const& stats : _sections) {
+        sections.push_back({
+            {"name", stats.name},
+            {"calls", stats.calls},
+            {"seconds", to_seconds(stats.time)}
+        });
+    }
+
+    auto counters = nlohmann::json::object();
+    for (auto const& [name, value] : _counters) {
+        counters[name] = value;
+    }
+
+    nlohmann::json json;
+    json["sections"] = sections;
+    json["counters"] = counters;
+    return json.dump(2);
+}
+
+
+std::string profiler::format_csv() const
+{
+    std::ostringstream csv;
+
+    csv << "kind,name,calls,seconds\n";
+    for (auto const& stats : _sections) {
+        csv << "section," << stats.name << ',' << stats.calls << ',' << to_seconds(stats.time) << '\n';
+    }
+    for (auto const& [name, value] : _counters) {
+        csv << "counter," << name << ',' << value << ",\n";
+    }
+
+    return csv.str();
+}
+
+
+void profiler::save(std::string const& filename) const
+{
+    std::ofstream file{filename};
+    file << (ends_with(filename, ".csv") ? format_csv() : format_json());
+
+    if (!file.flush()) {
+        throw std::runtime_error("failed to write profile: " + filename);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// This module defines simd_level, the instruction set used by the multiversioned
+// pair kernels. Kernels are compiled for every level with target attributes so
+// that a single binary built for the baseline (SSE4) can run wider vectors.
+
+#include <string>
+
+
+// Enum: simd_level
+//
+// Instruction set selected for the pair kernels. sse is the default since
+// the results are reproducible across machines. Wider levels evaluate
+// mixed_softcore_potential pairs in blocks of 4 (avx2) or 8 (avx512) vector
+// lanes, use FMA and may differ in the last bits. Other potentials run the
+// scalar loop at every level.
+//
+enum class simd_level
+{
+    sse,
+    avx2,
+    avx512,
+};
+
+
+// Function: detect_simd_level
+//
+// Returns the widest level supported by the running CPU.
+//
+simd_level detect_simd_level();
+
+
+// Function: parse_simd_level
+//
+// Parses a level name: "sse", "avx2", "avx512" or "auto". "auto" selects the
+// widest level supported by the CPU. Throws std::runtime_error if the name is
+// unknown or the level is not supported by the CPU.
+//
+simd_level parse_simd_level(std::string const& name);
+
+
+// Function: format_simd_level
+//
+// Returns the name of a level.
+//
+std::string format_simd_level(simd_level level);
+
+
+// Macros: SIMD_TARGET_AVX2, SIMD_TARGET_AVX512
+//
+// Attributes compiling a function for the AVX2 and AVX-512 levels.
+//
+#define SIMD_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+
+// Macro: SIMD_INLINE
+//
+// Attribute forcing a kernel body to be inlined into each target-specific
+// instance so that the body is compiled for that instruction set.
+//
+#define SIMD_INLINE inline __attribute__((always_inline))
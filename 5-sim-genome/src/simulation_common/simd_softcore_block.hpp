@@ -0,0 +1,208 @@
+#pragma once
+
+// This module defines vectorized evaluation of mixed_softcore_potential over
+// blocks of pairs in structure-of-arrays lanes. Used by the AVX2 and AVX-512
+// instances of parallel_pair_kernel.
+
+#include <cstdint>
+#include <type_traits>
+
+#include <md.hpp>
+
+#include "mixed_softcore_potential.hpp"
+#include "simd_level.hpp"
+
+
+// Wide vectors are only passed between always-inlined helpers, so their ABI
+// does not matter.
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace detail
+{
+    // Vector types of W lanes. Specialized for each width since GCC ignores
+    // vector_size with a dependent size.
+    template<int W>
+    struct simd_types;
+
+    template<>
+    struct simd_types<4>
+    {
+        using vec = md::scalar __attribute__((vector_size(32)));
+        using mask = std::int64_t __attribute__((vector_size(32)));
+    };
+
+    template<>
+    struct simd_types<8>
+    {
+        using vec = md::scalar __attribute__((vector_size(64)));
+        using mask = std::int64_t __attribute__((vector_size(64)));
+    };
+
+    template<int W>
+    using simd_vec = typename simd_types<W>::vec;
+
+    template<int W>
+    using simd_mask = typename simd_types<W>::mask;
+
+    // Helpers are always inlined so that they are compiled for the target of
+    // the calling kernel instance. Results are written to out parameters
+    // since GCC warns about wide vectors returned by value from a function
+    // compiled for the baseline, even if it is inlined.
+
+    template<int N, int W>
+    SIMD_INLINE void vec_power(simd_vec<W> const& x, simd_vec<W>& result)
+    {
+        if constexpr (N == 0) {
+            result = x * 0 + 1;
+        } else if constexpr (N % 2 == 0) {
+            simd_vec<W> half;
+            vec_power<N / 2, W>(x, half);
+            result = half * half;
+        } else {
+            simd_vec<W> rest;
+            vec_power<N - 1, W>(x, rest);
+            result = x * rest;
+        }
+    }
+
+    template<int W>
+    SIMD_INLINE bool any_nonzero(simd_vec<W> const& v)
+    {
+        for (int lane = 0; lane < W; lane++) {
+            if (v[lane] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Structure: softcore_block
+    //
+    // Displacements and potential parameters of W pairs.
+    //
+    template<int W>
+    struct softcore_block
+    {
+        simd_vec<W> dx;
+        simd_vec<W> dy;
+        simd_vec<W> dz;
+        simd_vec<W> r2;
+        simd_vec<W> a_energy;
+        simd_vec<W> a_diameter;
+        simd_vec<W> b_energy;
+        simd_vec<W> b_diameter;
+    };
+
+    // Adds F/r and the energy of the term e (1 - (r/d)^P)^Q, which is zero at
+    // r >= d, to coef and energy. Same formulas as mixed_softcore_potential.
+    template<int P, int Q, bool with_force, bool with_energy, int W>
+    SIMD_INLINE void add_softcore_term(
+        simd_vec<W> const& e,
+        simd_vec<W> const& d,
+        simd_vec<W> const& r2,
+        simd_vec<W>&       coef,
+        simd_vec<W>&       energy
+    )
+    {
+        simd_vec<W> const k2 = 1 / (d * d);
+        simd_vec<W> const u2 = k2 * r2;
+        simd_mask<W> const inside = u2 < 1;
+
+        simd_vec<W> u_p2;
+        vec_power<P / 2 - 1, W>(u2, u_p2);
+        simd_vec<W> const g = 1 - u_p2 * u2;
+
+        simd_vec<W> g_q1;
+        vec_power<Q - 1, W>(g, g_q1);
+
+        if constexpr (with_force) {
+            simd_vec<W> const term = e * (P * Q) * k2 * u_p2 * g_q1;
+            coef += (simd_vec<W>) (inside & (simd_mask<W>) term);
+        }
+        if constexpr (with_energy) {
+            simd_vec<W> const term = e * g_q1 * g;
+            energy += (simd_vec<W>) (inside & (simd_mask<W>) term);
+        }
+    }
+}
+
+
+// Struct: softcore_block_evaluator
+//
+// Evaluates a pair potential over blocks of pairs. Defined only for potential
+// types that can be vectorized; is_simd_pair_potential tells whether the
+// evaluator is available.
+//
+template<typename Potential>
+struct softcore_block_evaluator;
+
+template<int AP, int AQ, int BP, int BQ>
+struct softcore_block_evaluator<mixed_softcore_potential<AP, AQ, BP, BQ>>
+{
+    // Function: load
+    //
+    // Stores the parameters of a potential to given lane of a block.
+    //
+    template<int W>
+    static SIMD_INLINE void load(
+        detail::softcore_block<W>&                      block,
+        int                                             lane,
+        mixed_softcore_potential<AP, AQ, BP, BQ> const& potential
+    )
+    {
+        block.a_energy[lane] = potential.a_energy;
+        block.a_diameter[lane] = potential.a_diameter;
+        block.b_energy[lane] = potential.b_energy;
+        block.b_diameter[lane] = potential.b_diameter;
+    }
+
+    // Function: evaluate
+    //
+    // Computes F/r and the energies of the pairs in a block into coef and
+    // energy. A term with zero weight in all lanes is skipped.
+    //
+    template<bool with_force, bool with_energy, int W>
+    static SIMD_INLINE void evaluate(
+        detail::softcore_block<W> const& block,
+        detail::simd_vec<W>&             coef,
+        detail::simd_vec<W>&             energy
+    )
+    {
+        coef = detail::simd_vec<W>{};
+        energy = detail::simd_vec<W>{};
+
+        if (detail::any_nonzero<W>(block.a_energy)) {
+            detail::add_softcore_term<AP, AQ, with_force, with_energy, W>(
+                block.a_energy, block.a_diameter, block.r2, coef, energy
+            );
+        }
+        if (detail::any_nonzero<W>(block.b_energy)) {
+            detail::add_softcore_term<BP, BQ, with_force, with_energy, W>(
+                block.b_energy, block.b_diameter, block.r2, coef, energy
+            );
+        }
+    }
+};
+
+
+// Struct: is_simd_pair_potential
+//
+// True if pairs of potential type T can be evaluated in SIMD blocks, i.e.,
+// softcore_block_evaluator<T> is defined.
+//
+template<typename T>
+struct is_simd_pair_potential : std::false_type
+{
+};
+
+template<int AP, int AQ, int BP, int BQ>
+struct is_simd_pair_potential<mixed_softcore_potential<AP, AQ, BP, BQ>> : std::true_type
+{
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic pop
+#endif
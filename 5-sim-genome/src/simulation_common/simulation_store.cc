@@ -2,8 +2,16 @@
 #include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <highfive/H5Attribute.hpp>
@@ -16,12 +24,17 @@
 #include <md.hpp>
 
 #include "h5/vector_array.hpp"
+#include "contact_codec.hpp"
 #include "particle_data.hpp"
+#include "position_codec.hpp"
 #include "simulation_store.hpp"
 
 
 namespace
 {
+    // Aim for 1MB.
+    constexpr std::size_t h5_chunk_size = 1024 * 1024;
+
     template<typename T, std::size_t cols>
     H5::DataSet write_compressed_array(
         H5::Group& group,
@@ -29,26 +42,139 @@ namespace
         std::vector<std::array<T, cols>> const& data
     );
 
+    template<typename T>
+    H5::DataSet write_compressed_vector(
+        H5::Group& group,
+        std::string const& name,
+        std::vector<T> const& data
+    );
+
+    template<typename T>
+    H5::DataSet write_compressed_matrix(
+        H5::Group& group,
+        std::string const& name,
+        std::vector<T> const& data,
+        std::size_t rows
+    );
+
     void clear_dataset(H5::Group& group, std::string const& name);
 
     template<typename G>
     H5::Group require_group(G& parent, std::string name);
 
-    template<typename G>
-    H5::Group require_snapshot_group(G& root, std::string phase, md::step step);
+    template<typename T>
+    void create_extendible_dataset(
+        H5::Group& group, std::string const& name, std::vector<T> const& values
+    );
+
+    template<typename T>
+    void append_to_dataset(H5::Group& group, std::string const& name, T const& value);
+
+    std::set<md::step> read_step_index(H5::Group& group);
+    bool is_step_index_appendable(H5::Group& group);
+    void write_step_index(H5::Group& group, std::set<md::step> const& steps);
+    void append_step_index(H5::Group& group, md::step step);
 
     float quantize(md::scalar val, int bits);
+    std::vector<md::point> to_points(std::vector<std::array<float, 3>> const& coords_array);
+
+    // Datasets of the "history" position layout in a phase group.
+    constexpr char const* positions_history_name = "positions_history";
+    constexpr char const* history_steps_name = "positions_history_steps";
+
+    // HDF5 library is not thread-safe in the default build. Every call into
+    // the library is made under this mutex.
+    std::mutex& hdf5_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
 }
 
 
 simulation_store::simulation_store(std::string const& filename)
-    : _store{filename, H5::File::ReadWrite}
+    : _file_lock{hdf5_mutex()}
+    , _store{filename, H5::File::ReadWrite}
+{
+    _file_lock.unlock();
+}
+
+
+simulation_store::~simulation_store()
+{
+    try {
+        stop_writer();
+    } catch (std::exception const& err) {
+        std::cerr << "error: failed to save snapshot: " << err.what() << '\n';
+    }
+
+    // _store is destroyed (closed) after this body and _file_lock after that.
+    _file_lock.lock();
+}
+
+
+void simulation_store::set_queue_size(md::index size)
+{
+    stop_writer();
+
+    if (size > 0) {
+        start_writer(size);
+    }
+}
+
+
+void simulation_store::set_contact_format(std::string const& format)
+{
+    if (format != "csr" && format != "triplet") {
+        throw std::runtime_error("unknown contact map format: " + format);
+    }
+
+    // The writer thread reads the format.
+    sync();
+    _contact_format = format;
+}
+
+
+void simulation_store::set_position_format(std::string const& format)
+{
+    if (format != "delta" && format != "float") {
+        throw std::runtime_error("unknown position format: " + format);
+    }
+
+    // The writer thread reads the format.
+    sync();
+    _position_format = format;
+}
+
+
+void simulation_store::set_position_layout(std::string const& layout)
+{
+    if (layout != "snapshot" && layout != "history") {
+        throw std::runtime_error("unknown position layout: " + layout);
+    }
+
+    // The writer thread reads the layout.
+    sync();
+    _position_layout = layout;
+}
+
+
+void simulation_store::sync()
 {
+    std::unique_lock<std::mutex> lock{_queue_mutex};
+    _queue_signal.wait(lock, [&] { return _queue_count == 0; });
+
+    if (_writer_error) {
+        std::rethrow_exception(std::exchange(_writer_error, nullptr));
+    }
 }
 
 
 simulation_config simulation_store::load_config()
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     auto metadata = _store.getGroup("metadata");
     auto config_data = metadata.getDataSet("config");
 
@@ -63,6 +189,9 @@ simulation_config simulation_store::load_config()
 
 std::vector<chromosome_range> simulation_store::load_chromosomes()
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     auto metadata = _store.getGroup("metadata");
     auto chromosome_ranges_data = metadata.getDataSet("chromosome_ranges");
     auto centromere_ranges_data = metadata.getDataSet("centromere_ranges");
@@ -103,6 +232,9 @@ std::vector<chromosome_range> simulation_store::load_chromosomes()
 
 std::vector<particle_data> simulation_store::load_particle_data()
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     auto metadata = _store.getGroup("metadata");
     auto ab_factors_data = metadata.getDataSet("ab_factors");
 
@@ -125,6 +257,9 @@ std::vector<particle_data> simulation_store::load_particle_data()
 
 std::vector<index_range> simulation_store::load_nucleolus_ranges()
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     std::vector<std::array<int, 2>> range_values;
     auto metadata = _store.getGroup("metadata");
     auto nucleolus_ranges_data = metadata.getDataSet("nucleolus_ranges");
@@ -150,6 +285,9 @@ std::vector<index_range> simulation_store::load_nucleolus_ranges()
 
 std::vector<nucleolus_bond> simulation_store::load_nucleolus_bonds()
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     std::vector<std::array<int, 2>> index_pairs;
     auto metadata = _store.getGroup("metadata");
     auto nucleolus_bond_data = metadata.getDataSet("nucleolus_bonds");
@@ -169,6 +307,21 @@ std::vector<nucleolus_bond> simulation_store::load_nucleolus_bonds()
 }
 
 
+void simulation_store::save_profile(std::string const& name, std::string const& profile_json)
+{
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto metadata_group = require_group(_store, "metadata");
+    auto profiles_group = require_group(metadata_group, "profiles");
+
+    clear_dataset(profiles_group, name);
+    profiles_group.createDataSet(name, profile_json);
+
+    _store.flush();
+}
+
+
 void simulation_store::set_phase(std::string const& phase)
 {
     _phase = phase;
@@ -177,6 +330,9 @@ void simulation_store::set_phase(std::string const& phase)
 
 void simulation_store::save_chromosomes(md::array_view<chromosome_range const> chroms)
 {
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
     auto snapshots_group = require_group(_store, "snapshots");
     auto phase_group = require_group(snapshots_group, _phase);
     auto metadata_group = require_group(phase_group, "metadata");
@@ -202,7 +358,25 @@ void simulation_store::save_chromosomes(md::array_view<chromosome_range const> c
 
 void simulation_store::save_context(md::step step, simulation_context const& context)
 {
-    auto snapshot = require_snapshot_group(_store, _phase, step);
+    if (_writer.joinable()) {
+        enqueue([&](snapshot_record& record) {
+            record.kind    = record_kind::context;
+            record.step    = step;
+            record.context = context;
+        });
+        return;
+    }
+    write_context(_phase, step, context);
+}
+
+
+void simulation_store::write_context(
+    std::string const& phase, md::step step, simulation_context const& context
+)
+{
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto snapshot = require_snapshot_group(phase, step);
 
     std::vector<md::scalar> const wall_semiaxes = {
         context.wall_semiaxes.x,
@@ -227,9 +401,23 @@ void simulation_store::save_context(md::step step, simulation_context const& con
 }
 
 
+simulation_metadata simulation_store::load_metadata()
+{
+    return {
+        .chromosomes      = load_chromosomes(),
+        .particles        = load_particle_data(),
+        .nucleolus_ranges = load_nucleolus_ranges(),
+        .nucleolus_bonds  = load_nucleolus_bonds()
+    };
+}
+
+
 simulation_context simulation_store::load_context(md::step step)
 {
-    auto snapshot = require_snapshot_group(_store, _phase, step);
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto snapshot = require_snapshot_group(_phase, step);
 
     std::string context_json;
     snapshot.getDataSet("context").read(context_json);
@@ -252,12 +440,48 @@ simulation_context simulation_store::load_context(md::step step)
 
 void simulation_store::save_positions(md::step step, md::array_view<md::point const> positions)
 {
-    auto snapshot = require_snapshot_group(_store, _phase, step);
+    if (_writer.joinable()) {
+        enqueue([&](snapshot_record& record) {
+            record.kind = record_kind::positions;
+            record.step = step;
+            record.positions.assign(positions.begin(), positions.end());
+        });
+        return;
+    }
+    write_positions(_phase, step, positions);
+}
 
+
+void simulation_store::write_positions(
+    std::string const& phase, md::step step, md::array_view<md::point const> positions
+)
+{
     // Quantize coordinate values for better compression. Resolution of
     // ~0.0001 (0.1 nm) is sufficient for our simulation, so use 16 bits.
     constexpr int fraction_bits = 16;
 
+    // Fixed-point residuals are small and packed tightly without a general
+    // purpose compressor, which is slow.
+    packed_positions packed;
+    if (_position_layout == "snapshot" &&
+        _position_format == "delta" &&
+        encode_packed_positions(positions, fraction_bits, packed)) {
+        std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+        auto snapshot = require_snapshot_group(phase, step);
+        clear_dataset(snapshot, "positions");
+
+        auto positions_group = snapshot.createGroup("positions");
+        positions_group.createAttribute("format", std::string("delta"));
+        positions_group.createAttribute("point_count", packed.point_count);
+        positions_group.createAttribute("fraction_bits", packed.fraction_bits);
+        positions_group.createDataSet("widths", packed.widths);
+        positions_group.createDataSet("payload", packed.payload);
+
+        _store.flush();
+        return;
+    }
+
     std::vector<std::array<float, 3>> positions_array(positions.size());
     for (md::index i = 0; i < positions.size(); i++) {
         positions_array[i] = {
@@ -267,6 +491,18 @@ void simulation_store::save_positions(md::step step, md::array_view<md::point co
         };
     }
 
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto snapshot = require_snapshot_group(phase, step);
+
+    if (_position_layout == "history") {
+        auto snapshots_group = require_group(_store, "snapshots");
+        auto phase_group = require_group(snapshots_group, phase);
+        write_positions_history(phase, phase_group, step, positions_array);
+        _store.flush();
+        return;
+    }
+
     clear_dataset(snapshot, "positions");
     write_compressed_array(snapshot, "positions", positions_array);
 
@@ -276,24 +512,129 @@ void simulation_store::save_positions(md::step step, md::array_view<md::point co
 }
 
 
+void simulation_store::write_positions_history(
+    std::string const& phase,
+    H5::Group& phase_group,
+    md::step step,
+    std::vector<std::array<float, 3>> const& positions
+)
+{
+    auto& steps = load_history_steps(phase, phase_group);
+    std::size_t const particle_count = positions.size();
+
+    if (!phase_group.exist(positions_history_name)) {
+        // A chunk holds a frame, or a part of it for a huge system.
+        auto const chunk_particles = std::max(
+            std::min(h5_chunk_size / sizeof(float[3]), particle_count), std::size_t(1)
+        );
+
+        H5::DataSpace dataspace(
+            {0, particle_count, 3}, {H5::DataSpace::UNLIMITED, particle_count, 3}
+        );
+        H5::DataSetCreateProps props;
+        props.add(H5::Chunking(std::vector<hsize_t>{1, chunk_particles, 3}));
+        props.add(H5::Shuffle());
+        props.add(H5::Deflate(6));
+
+        phase_group.createDataSet<float>(positions_history_name, dataspace, props);
+        create_extendible_dataset(phase_group, history_steps_name, std::vector<std::int64_t>{});
+    }
+
+    auto dataset = phase_group.getDataSet(positions_history_name);
+    auto const dims = dataset.getDimensions();
+    if (dims.size() != 3 || dims[1] != particle_count || dims[2] != 3) {
+        throw std::runtime_error("positions history does not match the number of particles");
+    }
+
+    // A resumed run may save a step again. Overwrite the frame then.
+    auto const it = std::lower_bound(steps.begin(), steps.end(), step);
+    auto const frame = static_cast<std::size_t>(it - steps.begin());
+
+    if (it == steps.end()) {
+        dataset.resize({frame + 1, particle_count, 3});
+        append_to_dataset(phase_group, history_steps_name, static_cast<std::int64_t>(step));
+        steps.push_back(step);
+    } else if (*it != step) {
+        throw std::runtime_error("positions history must be saved in the order of steps");
+    }
+
+    if (particle_count > 0) {
+        dataset.select({frame, 0, 0}, {1, particle_count, 3}).write_raw(positions.front().data());
+    }
+}
+
+
+std::vector<md::step>& simulation_store::load_history_steps(
+    std::string const& phase, H5::Group& phase_group
+)
+{
+    auto it = _history_steps.find(phase);
+
+    if (it == _history_steps.end()) {
+        std::vector<md::step> steps;
+
+        if (phase_group.exist(history_steps_name)) {
+            std::vector<std::int64_t> values;
+            phase_group.getDataSet(history_steps_name).read(values);
+            for (auto const value : values) {
+                steps.push_back(static_cast<md::step>(value));
+            }
+        }
+        it = _history_steps.emplace(phase, std::move(steps)).first;
+    }
+
+    return it->second;
+}
+
+
 std::vector<md::point> simulation_store::load_positions(md::step step)
 {
-    auto snapshot = require_snapshot_group(_store, _phase, step);
+    sync();
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
 
     std::vector<std::array<float, 3>> positions_array;
-    snapshot.getDataSet("positions").read(positions_array);
 
-    std::vector<md::point> positions;
-    positions.reserve(positions_array.size());
-    for (auto const& coords : positions_array) {
-        positions.push_back({
-            static_cast<md::scalar>(coords[0]),
-            static_cast<md::scalar>(coords[1]),
-            static_cast<md::scalar>(coords[2])
-        });
+    auto snapshots_group = require_group(_store, "snapshots");
+    auto phase_group = require_group(snapshots_group, _phase);
+    auto const& history_steps = load_history_steps(_phase, phase_group);
+    auto const history_it = std::lower_bound(history_steps.begin(), history_steps.end(), step);
+
+    if (history_it != history_steps.end() && *history_it == step) {
+        auto const frame = static_cast<std::size_t>(history_it - history_steps.begin());
+        auto dataset = phase_group.getDataSet(positions_history_name);
+        std::size_t const particle_count = dataset.getDimensions().at(1);
+
+        positions_array.resize(particle_count);
+        if (particle_count > 0) {
+            dataset.select({frame, 0, 0}, {1, particle_count, 3})
+                .read(positions_array.front().data());
+        }
+        return to_points(positions_array);
+    }
+
+    auto snapshot = require_snapshot_group(_phase, step);
+
+    if (snapshot.getObjectType("positions") == H5::ObjectType::Group) {
+        auto positions_group = snapshot.getGroup("positions");
+
+        std::string format;
+        positions_group.getAttribute("format").read(format);
+        if (format != "delta") {
+            throw std::runtime_error("unknown position format: " + format);
+        }
+
+        packed_positions packed;
+        positions_group.getAttribute("point_count").read(packed.point_count);
+        positions_group.getAttribute("fraction_bits").read(packed.fraction_bits);
+        positions_group.getDataSet("widths").read(packed.widths);
+        positions_group.getDataSet("payload").read(packed.payload);
+
+        return decode_packed_positions(packed);
     }
 
-    return positions;
+    snapshot.getDataSet("positions").read(positions_array);
+
+    return to_points(positions_array);
 }
 
 
@@ -305,20 +646,250 @@ void simulation_store::save_contacts(
         return;
     }
 
-    auto snapshot = require_snapshot_group(_store, _phase, step);
+    if (_writer.joinable()) {
+        enqueue([&](snapshot_record& record) {
+            record.kind = record_kind::contacts;
+            record.step = step;
+            record.contacts.assign(contacts.begin(), contacts.end());
+        });
+        return;
+    }
+    write_contacts(_phase, step, contacts);
+}
+
+
+void simulation_store::write_contacts(
+    std::string const& phase,
+    md::step step,
+    std::vector<std::array<std::uint32_t, 3>> const& contacts
+)
+{
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto snapshot = require_snapshot_group(phase, step);
     clear_dataset(snapshot, "contact_map");
-    write_compressed_array(snapshot, "contact_map", contacts);
+
+    if (_contact_format == "triplet") {
+        write_compressed_array(snapshot, "contact_map", contacts);
+        _store.flush();
+        return;
+    }
+
+    // Rows are implicit and columns are small deltas, which compress far
+    // better than the (i,j,v) triplets.
+    auto const csr = encode_csr_contacts(contacts);
+    auto contact_group = snapshot.createGroup("contact_map");
+    contact_group.createAttribute("format", std::string("csr"));
+    write_compressed_vector(contact_group, "row_offsets", csr.row_offsets);
+    write_compressed_vector(contact_group, "column_deltas", csr.column_deltas);
+    write_compressed_vector(contact_group, "counts", csr.counts);
+    write_compressed_vector(contact_group, "count_overflows", csr.count_overflows);
 
     _store.flush();
 }
 
 
-namespace
+void simulation_store::save_contact_profile(md::step step, contact_profile_data const& profile)
 {
-    // Aim for 1MB.
-    constexpr std::size_t h5_chunk_size = 1024 * 1024;
+    if (_writer.joinable()) {
+        enqueue([&](snapshot_record& record) {
+            record.kind = record_kind::contact_profile;
+            record.step = step;
+            record.contact_profile.chromosome_count = profile.chromosome_count;
+            record.contact_profile.distance_counts.assign(
+                profile.distance_counts.begin(), profile.distance_counts.end()
+            );
+            record.contact_profile.nucleolus_counts.assign(
+                profile.nucleolus_counts.begin(), profile.nucleolus_counts.end()
+            );
+        });
+        return;
+    }
+    write_contact_profile(_phase, step, profile);
+}
+
+
+void simulation_store::write_contact_profile(
+    std::string const& phase, md::step step, contact_profile_data const& profile
+)
+{
+    std::lock_guard<std::mutex> hdf5_lock{hdf5_mutex()};
+
+    auto snapshot = require_snapshot_group(phase, step);
+    clear_dataset(snapshot, "contact_distances");
+    clear_dataset(snapshot, "nucleolus_contacts");
+
+    write_compressed_matrix(
+        snapshot, "contact_distances", profile.distance_counts, profile.chromosome_count
+    );
+    write_compressed_vector(snapshot, "nucleolus_contacts", profile.nucleolus_counts);
+
+    _store.flush();
+}
+
+
+template<typename Fill>
+void simulation_store::enqueue(Fill fill)
+{
+    std::unique_lock<std::mutex> lock{_queue_mutex};
+    _queue_signal.wait(lock, [&] { return _queue_count < _queue.size(); });
+
+    if (_writer_error) {
+        std::rethrow_exception(std::exchange(_writer_error, nullptr));
+    }
+
+    // The writer thread only touches the record at the head, so the tail
+    // record is ours to fill.
+    auto& record = _queue[(_queue_head + _queue_count) % _queue.size()];
+    record.phase = _phase;
+    fill(record);
+    _queue_count++;
+
+    lock.unlock();
+    _queue_signal.notify_all();
+}
+
+
+void simulation_store::start_writer(md::index size)
+{
+    _queue.resize(size);
+    _queue_head = 0;
+    _queue_count = 0;
+    _writer_exiting = false;
+    _writer = std::thread{[this] { run_writer(); }};
+}
+
+
+void simulation_store::stop_writer()
+{
+    if (!_writer.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{_queue_mutex};
+        _writer_exiting = true;
+    }
+    _queue_signal.notify_all();
+
+    // The writer drains the queue before exiting.
+    _writer.join();
+    _queue.clear();
+
+    if (_writer_error) {
+        std::rethrow_exception(std::exchange(_writer_error, nullptr));
+    }
+}
 
 
+void simulation_store::run_writer()
+{
+    std::unique_lock<std::mutex> lock{_queue_mutex};
+
+    for (;;) {
+        _queue_signal.wait(lock, [&] { return _queue_count > 0 || _writer_exiting; });
+
+        if (_queue_count == 0) {
+            break;
+        }
+
+        auto const& record = _queue[_queue_head];
+        auto const failed = bool(_writer_error);
+        std::exception_ptr error;
+
+        lock.unlock();
+
+        // Records queued after a failure are discarded. The error is reported
+        // to the simulation thread on the next save or sync.
+        if (!failed) {
+            try {
+                write_record(record);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+
+        if (error) {
+            _writer_error = error;
+        }
+        _queue_head = (_queue_head + 1) % _queue.size();
+        _queue_count--;
+        _queue_signal.notify_all();
+    }
+}
+
+
+void simulation_store::write_record(snapshot_record const& record)
+{
+    switch (record.kind) {
+    case record_kind::positions:
+        write_positions(record.phase, record.step, record.positions);
+        break;
+
+    case record_kind::context:
+        write_context(record.phase, record.step, record.context);
+        break;
+
+    case record_kind::contacts:
+        write_contacts(record.phase, record.step, record.contacts);
+        break;
+
+    case record_kind::contact_profile:
+        write_contact_profile(record.phase, record.step, record.contact_profile);
+        break;
+    }
+}
+
+
+H5::Group simulation_store::require_snapshot_group(std::string const& phase, md::step step)
+{
+    auto snapshots_group = require_group(_store, "snapshots");
+    auto phase_group = require_group(snapshots_group, phase);
+    auto snapshot_group = require_group(phase_group, std::to_string(step));
+
+    auto& index = load_step_index(phase, phase_group);
+
+    if (index.steps.empty() || step > *index.steps.rbegin()) {
+        index.steps.insert(step);
+        if (index.appendable) {
+            append_step_index(phase_group, step);
+            return snapshot_group;
+        }
+    } else if (!index.steps.insert(step).second) {
+        return snapshot_group;
+    }
+
+    // Out-of-order step or legacy non-extendible datasets. Rewrite the whole
+    // index once; subsequent steps are appended.
+    write_step_index(phase_group, index.steps);
+    index.appendable = true;
+
+    return snapshot_group;
+}
+
+
+simulation_store::step_index& simulation_store::load_step_index(
+    std::string const& phase, H5::Group& phase_group
+)
+{
+    auto it = _step_indices.find(phase);
+
+    if (it == _step_indices.end()) {
+        step_index index;
+        index.steps = read_step_index(phase_group);
+        index.appendable = is_step_index_appendable(phase_group);
+        it = _step_indices.emplace(phase, std::move(index)).first;
+    }
+
+    return it->second;
+}
+
+
+namespace
+{
+
     template<typename T, std::size_t cols>
     H5::DataSet write_compressed_array(
         H5::Group& group,
@@ -344,6 +915,63 @@ namespace
     }
 
 
+    template<typename T>
+    H5::DataSet write_compressed_vector(
+        H5::Group& group,
+        std::string const& name,
+        std::vector<T> const& data
+    )
+    {
+        // Chunked dataset cannot be empty.
+        if (data.empty()) {
+            return group.createDataSet<T>(name, H5::DataSpace(0));
+        }
+
+        auto const chunk_size = std::min(h5_chunk_size / sizeof(T), data.size());
+
+        H5::DataSpace dataspace(data.size());
+        H5::DataSetCreateProps props;
+        props.add(H5::Chunking(chunk_size));
+        props.add(H5::Shuffle());
+        props.add(H5::Deflate(6));
+
+        auto dataset = group.createDataSet<T>(name, dataspace, props);
+        dataset.write(data);
+
+        return dataset;
+    }
+
+
+    template<typename T>
+    H5::DataSet write_compressed_matrix(
+        H5::Group& group,
+        std::string const& name,
+        std::vector<T> const& data,
+        std::size_t rows
+    )
+    {
+        auto const cols = rows == 0 ? 0 : data.size() / rows;
+
+        // Chunked dataset cannot be empty.
+        if (data.empty()) {
+            return group.createDataSet<T>(name, H5::DataSpace(rows, cols));
+        }
+
+        auto const chunk_rows = std::clamp(h5_chunk_size / sizeof(T) / cols, std::size_t(1), rows);
+
+        H5::DataSpace dataspace(rows, cols);
+        H5::DataSetCreateProps props;
+        props.add(H5::Chunking(chunk_rows, cols));
+        props.add(H5::Shuffle());
+        props.add(H5::Deflate(6));
+
+        auto dataset = group.createDataSet<T>(name, dataspace, props);
+        dataset.write_raw(data.data());
+
+        return dataset;
+    }
+
+
     void clear_dataset(H5::Group& group, std::string const& name)
     {
         if (group.exist(name)) {
@@ -362,41 +990,113 @@ namespace
     }
 
 
-    template<typename G>
-    void update_ordered_steps(G& group, md::step new_step)
+    constexpr char const* step_index_name = ".step_index";
+    constexpr char const* step_names_name = ".steps";
+    constexpr std::size_t step_index_chunk_size = 1024;
+
+
+    // Function: read_step_index
+    //
+    // Reads the steps of the snapshots saved in a phase group. Legacy files
+    // only have the string list of steps.
+    //
+    std::set<md::step> read_step_index(H5::Group& group)
     {
-        constexpr char const* dataset_name = ".steps";
+        std::set<md::step> steps;
 
-        std::vector<std::string> steps;
-        if (group.exist(dataset_name)) {
-            group.getDataSet(dataset_name).read(steps);
-        } else {
-            group.createDataSet(dataset_name, steps);
+        if (group.exist(step_index_name)) {
+            std::vector<std::int64_t> values;
+            group.getDataSet(step_index_name).read(values);
+            for (auto const value : values) {
+                steps.insert(static_cast<md::step>(value));
+            }
+        } else if (group.exist(step_names_name)) {
+            std::vector<std::string> names;
+            group.getDataSet(step_names_name).read(names);
+            for (auto const& name : names) {
+                steps.insert(static_cast<md::step>(std::stol(name)));
+            }
         }
 
-        std::set<long> sorted_steps;
-        for (auto const step : steps) {
-            sorted_steps.insert(std::stol(step));
+        return steps;
+    }
+
+
+    // Function: is_step_index_appendable
+    //
+    // Checks if the step datasets in a phase group are both extendible.
+    //
+    bool is_step_index_appendable(H5::Group& group)
+    {
+        for (auto const name : {step_index_name, step_names_name}) {
+            if (!group.exist(name)) {
+                return false;
+            }
+            auto const max_dims = group.getDataSet(name).getSpace().getMaxDimensions();
+            if (max_dims.size() != 1 || max_dims[0] != H5::DataSpace::UNLIMITED) {
+                return false;
+            }
         }
-        sorted_steps.insert(static_cast<long>(new_step));
+        return true;
+    }
+
 
-        steps.clear();
-        for (auto const step : sorted_steps) {
-            steps.push_back(std::to_string(step));
+    template<typename T>
+    void create_extendible_dataset(
+        H5::Group& group, std::string const& name, std::vector<T> const& values
+    )
+    {
+        H5::DataSpace dataspace({values.size()}, {H5::DataSpace::UNLIMITED});
+        H5::DataSetCreateProps props;
+        props.add(H5::Chunking(step_index_chunk_size));
+
+        auto dataset = group.createDataSet<T>(name, dataspace, props);
+        if (!values.empty()) {
+            dataset.write(values);
         }
+    }
+
 
-        clear_dataset(group, dataset_name);
-        group.createDataSet(dataset_name, steps);
+    template<typename T>
+    void append_to_dataset(H5::Group& group, std::string const& name, T const& value)
+    {
+        auto dataset = group.getDataSet(name);
+        auto const size = dataset.getElementCount();
+        dataset.resize({size + 1});
+        dataset.select({size}, {1}).write(std::vector<T>{value});
     }
 
-    template<typename G>
-    H5::Group require_snapshot_group(G& root, std::string phase, md::step step)
+
+    // Function: write_step_index
+    //
+    // Recreates the step datasets in a phase group. The integer index is for
+    // fast lookup and the sorted string list is for existing readers.
+    //
+    void write_step_index(H5::Group& group, std::set<md::step> const& steps)
     {
-        auto snapshots_group = require_group(root, "snapshots");
-        auto phase_group = require_group(snapshots_group, phase);
-        auto snapshot_group = require_group(phase_group, std::to_string(step));
-        update_ordered_steps(phase_group, step);
-        return snapshot_group;
+        std::vector<std::int64_t> values;
+        std::vector<std::string> names;
+        for (auto const step : steps) {
+            values.push_back(static_cast<std::int64_t>(step));
+            names.push_back(std::to_string(step));
+        }
+
+        clear_dataset(group, step_index_name);
+        clear_dataset(group, step_names_name);
+        create_extendible_dataset(group, step_index_name, values);
+        create_extendible_dataset(group, step_names_name, names);
+    }
+
+
+    // Function: append_step_index
+    //
+    // Appends a step to the step datasets in a phase group. The step must be
+    // greater than the existing ones.
+    //
+    void append_step_index(H5::Group& group, md::step step)
+    {
+        append_to_dataset(group, step_index_name, static_cast<std::int64_t>(step));
+        append_to_dataset(group, step_names_name, std::to_string(step));
     }
 
 
@@ -405,4 +1105,19 @@ namespace
         float const scale = 1 << bits;
         return std::nearbyint(float(val) * scale) / scale;
     }
+
+
+    std::vector<md::point> to_points(std::vector<std::array<float, 3>> const& coords_array)
+    {
+        std::vector<md::point> points;
+        points.reserve(coords_array.size());
+        for (auto const& coords : coords_array) {
+            points.push_back({
+                static_cast<md::scalar>(coords[0]),
+                static_cast<md::scalar>(coords[1]),
+                static_cast<md::scalar>(coords[2])
+            });
+        }
+        return points;
+    }
 }
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <highfive/H5File.hpp>
@@ -40,6 +46,41 @@ struct index_range
 };
 
 
+// Structure: contact_profile_data
+//
+// Reductions of contacts small enough to save in every sampling frame.
+// distance_counts is a row-major (chromosome_count, max_distance) matrix
+// counting intra-chromosome contacts by genomic distance |i - j|.
+// nucleolus_counts counts contacts of each particle with nucleolar particles.
+//
+struct contact_profile_data
+{
+    md::index                  chromosome_count = 0;
+    std::vector<std::uint32_t> distance_counts;
+    std::vector<std::uint32_t> nucleolus_counts;
+};
+
+
+// Structure: simulation_metadata
+//
+// Aggregate of the static metadata of a system. Replicas of the same system
+// share this so that the metadata is loaded only once.
+//
+struct simulation_metadata
+{
+    std::vector<chromosome_range> chromosomes;
+    std::vector<particle_data>    particles;
+    std::vector<index_range>      nucleolus_ranges;
+    std::vector<nucleolus_bond>   nucleolus_bonds;
+};
+
+
+// Class: simulation_store
+//
+// Reads and writes simulation data in an HDF5 file. Multiple stores may be
+// used from different threads; calls into the HDF5 library are serialized
+// with a process-wide mutex.
+//
 class simulation_store
 {
 public:
@@ -47,12 +88,67 @@ public:
     // it in read-write mode.
     explicit simulation_store(std::string const& filename);
 
+    // Destructor writes out queued snapshots, if any.
+    ~simulation_store();
+
+    simulation_store(simulation_store const&) = delete;
+    simulation_store& operator=(simulation_store const&) = delete;
+
+    // Function: set_queue_size
+    //
+    // Switches snapshot saving to asynchronous mode. save_positions,
+    // save_context, save_contacts and save_contact_profile then only copy
+    // given data into a queue of at most `size` records, and a dedicated
+    // thread quantizes, compresses and writes the records to the file.
+    // Saving blocks only when the queue is full. Zero size (default) means
+    // synchronous mode.
+    //
+    void set_queue_size(md::index size);
+
+    // Function: sync
+    //
+    // Blocks until all queued snapshots are written. Rethrows an exception
+    // raised in the writer thread, if any.
+    //
+    void sync();
+
+    // Function: set_contact_format
+    //
+    // Sets the format of contact maps saved by save_contacts: "csr" (default)
+    // saves a group of CSR-encoded arrays (see contact_codec) and "triplet"
+    // saves an (i,j,v) array. Throws std::runtime_error for other formats.
+    //
+    void set_contact_format(std::string const& format);
+
+    // Function: set_position_format
+    //
+    // Sets the format of positions saved by save_positions: "delta" (default)
+    // saves a group of fixed-point residuals packed by position_codec and
+    // "float" saves a quantized float32 array. Positions that the codec
+    // cannot represent are saved in "float" format anyway. Throws
+    // std::runtime_error for other formats.
+    //
+    void set_position_format(std::string const& format);
+
+    // Function: set_position_layout
+    //
+    // Sets where save_positions saves positions: "snapshot" (default) saves
+    // them in the snapshot group of each step and "history" appends them to
+    // an extendible (frames, particles, 3) float32 dataset positions_history
+    // of the phase, along with the steps in positions_history_steps. Steps
+    // must be saved in increasing order in the latter. position_format does
+    // not apply to the latter. Throws std::runtime_error for other layouts.
+    //
+    void set_position_layout(std::string const& layout);
+
     // Metadata
     simulation_config             load_config();
     std::vector<chromosome_range> load_chromosomes();
     std::vector<particle_data>    load_particle_data();
     std::vector<index_range>      load_nucleolus_ranges();
     std::vector<nucleolus_bond>   load_nucleolus_bonds();
+    simulation_metadata           load_metadata();
+    void save_profile(std::string const& name, std::string const& profile_json);
 
     // Snapshot
     void set_phase(std::string const& phase);
@@ -60,11 +156,94 @@ public:
     void save_positions(md::step step, md::array_view<md::point const> positions);
     void save_context(md::step step, simulation_context const& context);
     void save_contacts(md::step step, std::vector<std::array<std::uint32_t, 3>> const& contacts);
+    void save_contact_profile(md::step step, contact_profile_data const& profile);
 
     std::vector<md::point> load_positions(md::step step);
     simulation_context     load_context(md::step step);
 
 private:
+    enum class record_kind
+    {
+        positions,
+        context,
+        contacts,
+        contact_profile,
+    };
+
+    // Snapshot data waiting in the queue. Records are reused in a ring so
+    // that the vectors keep their capacity once the queue warms up.
+    struct snapshot_record
+    {
+        record_kind                               kind = record_kind::positions;
+        std::string                               phase;
+        md::step                                  step = 0;
+        std::vector<md::point>                    positions;
+        simulation_context                        context;
+        std::vector<std::array<std::uint32_t, 3>> contacts;
+        contact_profile_data                      contact_profile;
+    };
+
+    // Steps of the snapshots saved in a phase. Cached so that saving a
+    // snapshot does not read and rewrite the whole list of steps.
+    struct step_index
+    {
+        std::set<md::step> steps;
+        bool               appendable = false;
+    };
+
+    H5::Group require_snapshot_group(std::string const& phase, md::step step);
+    step_index& load_step_index(std::string const& phase, H5::Group& phase_group);
+
+    template<typename Fill>
+    void enqueue(Fill fill);
+    void start_writer(md::index size);
+    void stop_writer();
+    void run_writer();
+    void write_record(snapshot_record const& record);
+
+    void write_positions(
+        std::string const& phase, md::step step, md::array_view<md::point const> positions
+    );
+    void write_positions_history(
+        std::string const& phase,
+        H5::Group& phase_group,
+        md::step step,
+        std::vector<std::array<float, 3>> const& positions
+    );
+    std::vector<md::step>& load_history_steps(std::string const& phase, H5::Group& phase_group);
+    void write_context(
+        std::string const& phase, md::step step, simulation_context const& context
+    );
+    void write_contacts(
+        std::string const& phase, md::step step, std::vector<std::array<std::uint32_t, 3>> const& contacts
+    );
+    void write_contact_profile(
+        std::string const& phase, md::step step, contact_profile_data const& profile
+    );
+
+private:
+    // Held while _store is opened and closed. Declared before _store so that
+    // it outlives _store in the destructor.
+    std::unique_lock<std::mutex> _file_lock;
+
     H5::File _store;
     std::string _phase = "unknown";
+    std::string _contact_format = "csr";
+    std::string _position_format = "delta";
+    std::string _position_layout = "snapshot";
+    std::map<std::string, step_index> _step_indices;
+
+    // Steps of the frames in the positions history of each phase.
+    std::map<std::string, std::vector<md::step>> _history_steps;
+
+    // Asynchronous writer. The writer thread is the only user of _store while
+    // the queue is not empty, so every other file operation calls sync first.
+    std::vector<snapshot_record> _queue;
+    md::index                    _queue_head = 0;
+    md::index                    _queue_count = 0;
+    std::mutex                   _queue_mutex;
+    std::condition_variable      _queue_signal;
+    std::thread                  _writer;
+    std::exception_ptr           _writer_error;
+    bool                         _writer_exiting = false;
 };
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <md.hpp>
+
+#include "worker_pool.hpp"
+
+
+worker_pool::worker_pool(md::index size)
+{
+    // The calling thread works as the zeroth worker.
+    for (md::index worker = 1; worker < std::max<md::index>(size, 1); worker++) {
+        _threads.emplace_back([=] { work(worker); });
+    }
+}
+
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _exiting = true;
+    }
+    _start_signal.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+
+md::index worker_pool::size() const
+{
+    return _threads.size() + 1;
+}
+
+
+std::pair<md::index, md::index> worker_pool::partition(md::index n, md::index worker) const
+{
+    auto const workers = size();
+    auto const begin = n * worker / workers;
+    auto const end = n * (worker + 1) / workers;
+    return {begin, end};
+}
+
+
+void worker_pool::run(task_type const& task)
+{
+    if (_threads.empty()) {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _task = &task;
+        _pending = _threads.size();
+        _generation++;
+    }
+    _start_signal.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock{_mutex};
+    _finish_signal.wait(lock, [&] { return _pending == 0; });
+    _task = nullptr;
+}
+
+
+void worker_pool::work(md::index worker)
+{
+    std::uint64_t generation = 0;
+
+    for (;;) {
+        task_type const* task;
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _start_signal.wait(lock, [&] {
+                return _exiting || _generation != generation;
+            });
+            if (_exiting) {
+                return;
+            }
+            generation = _generation;
+            task = _task;
+        }
+
+        (*task)(worker);
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _pending--;
+        }
+        _finish_signal.notify_one();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// This module defines worker_pool class, a minimal fork-join thread pool used
+// to evaluate forcefields in parallel.
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+
+// Class: worker_pool
+//
+// Fixed set of threads running the same task in fork-join style. The task
+// receives the index of the executing worker so that each worker can process
+// a deterministic share of the work.
+//
+class worker_pool
+{
+public:
+    using task_type = std::function<void(md::index)>;
+
+    // Constructor takes the number of workers including the calling thread.
+    explicit worker_pool(md::index size);
+
+    ~worker_pool();
+
+    worker_pool(worker_pool const&) = delete;
+    worker_pool& operator=(worker_pool const&) = delete;
+
+    // Function: size
+    //
+    // Returns the number of workers.
+    //
+    md::index size() const;
+
+    // Function: partition
+    //
+    // Returns the [begin, end) range of n items assigned to given worker. The
+    // items are split into contiguous, nearly equal-sized ranges.
+    //
+    std::pair<md::index, md::index> partition(md::index n, md::index worker) const;
+
+    // Function: run
+    //
+    // Calls task(w) for each worker w = 0, ..., size-1 concurrently and waits
+    // for all the calls to finish. The calling thread runs task(0).
+    //
+    void run(task_type const& task);
+
+private:
+    void work(md::index worker);
+
+private:
+    std::vector<std::thread> _threads;
+    std::mutex               _mutex;
+    std::condition_variable  _start_signal;
+    std::condition_variable  _finish_signal;
+    task_type const*         _task = nullptr;
+    std::uint64_t            _generation = 0;
+    md::index                _pending = 0;
+    bool                     _exiting = false;
+};
@@ -0,0 +1,192 @@
+// simulation_ensemble runs the interphase stage of many replicas of the same
+// system in one process. Metadata is loaded once and shared by the replicas,
+// and the replicas are run concurrently by a fixed number of jobs. Each
+// replica has its own trajectory file prepared as usual (prepare, spindle and
+// refine steps), typically with different seeds.
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+
+#include <md.hpp>
+
+#include "../simulation_common/command_line.hpp"
+#include "../simulation_common/simulation_store.hpp"
+#include "../simulation_interphase/simulation_driver.hpp"
+
+
+namespace
+{
+    char const* const usage =
+        "usage: simulation_ensemble [-j jobs] [-t threads] [-i isa] [-P] <trajectory>...\n";
+
+    option const long_options[] = {
+        {"jobs",          required_argument, nullptr, 'j'},
+        {"threads",       required_argument, nullptr, 't'},
+        {"isa",           required_argument, nullptr, 'i'},
+        {"profile-store", no_argument,       nullptr, 'P'},
+        {nullptr,         0,                 nullptr, 0  },
+    };
+
+    // Throws std::runtime_error if the system of a store differs from the
+    // shared metadata, i.e., the trajectory was prepared from another config.
+    void check_metadata(simulation_store& store, simulation_metadata const& metadata)
+    {
+        auto const chromosomes = store.load_chromosomes();
+        auto const nucleolus_ranges = store.load_nucleolus_ranges();
+        auto const nucleolus_bonds = store.load_nucleolus_bonds();
+
+        bool matches =
+            store.load_particle_data().size() == metadata.particles.size() &&
+            chromosomes.size() == metadata.chromosomes.size() &&
+            nucleolus_ranges.size() == metadata.nucleolus_ranges.size() &&
+            nucleolus_bonds.size() == metadata.nucleolus_bonds.size();
+
+        for (std::size_t i = 0; matches && i < chromosomes.size(); i++) {
+            auto const& chrom = chromosomes[i];
+            auto const& shared = metadata.chromosomes[i];
+            matches =
+                chrom.name == shared.name &&
+                chrom.start == shared.start &&
+                chrom.end == shared.end;
+        }
+
+        for (std::size_t i = 0; matches && i < nucleolus_ranges.size(); i++) {
+            matches =
+                nucleolus_ranges[i].begin == metadata.nucleolus_ranges[i].begin &&
+                nucleolus_ranges[i].end == metadata.nucleolus_ranges[i].end;
+        }
+
+        for (std::size_t i = 0; matches && i < nucleolus_bonds.size(); i++) {
+            matches =
+                nucleolus_bonds[i].nor_index == metadata.nucleolus_bonds[i].nor_index &&
+                nucleolus_bonds[i].nuc_index == metadata.nucleolus_bonds[i].nuc_index;
+        }
+
+        if (!matches) {
+            throw std::runtime_error("system differs from the first trajectory");
+        }
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    md::index jobs = 1;
+    md::index threads = 1;
+    std::string isa = "sse";
+    bool profile = false;
+
+    for (int opt; (opt = getopt_long(argc, argv, "j:t:i:P", long_options, nullptr)) != -1; ) {
+        switch (opt) {
+        case 'j':
+            if (!parse_index(optarg, jobs)) {
+                std::cerr << usage;
+                return 1;
+            }
+            break;
+
+        case 't':
+            if (!parse_index(optarg, threads)) {
+                std::cerr << usage;
+                return 1;
+            }
+            break;
+
+        case 'i':
+            isa = optarg;
+            break;
+
+        case 'P':
+            // Each replica saves its profile to its own trajectory file.
+            profile = true;
+            break;
+
+        default:
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> const filenames(argv + optind, argv + argc);
+
+    if (filenames.empty()) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<simulation_store>> stores;
+    std::shared_ptr<simulation_metadata const> metadata;
+
+    try {
+        for (auto const& filename : filenames) {
+            stores.push_back(std::make_unique<simulation_store>(filename));
+        }
+        metadata = std::make_shared<simulation_metadata const>(stores.front()->load_metadata());
+    } catch (std::exception const& err) {
+        std::cerr << "error: " << err.what() << '\n';
+        return 1;
+    }
+
+    // Each job takes the next replica until all replicas are done. A failed
+    // replica does not stop the others.
+    std::atomic<std::size_t> next_replica = 0;
+    std::vector<std::string> errors(filenames.size());
+
+    auto run_replicas = [&] {
+        for (std::size_t i; (i = next_replica++) < filenames.size(); ) {
+            try {
+                // Metadata is loaded from the first trajectory. A replica of
+                // another system would silently run on the wrong one.
+                if (i > 0) {
+                    check_metadata(*stores[i], *metadata);
+                }
+
+                driver_options options;
+                options.threads = threads;
+                options.metadata = metadata;
+                options.label = "<" + filenames[i] + "> ";
+                options.checkpoint_filename = filenames[i] + ".checkpoint";
+                options.profile.save_to_store = profile;
+                options.isa = isa;
+
+                simulation_driver driver{*stores[i], options};
+                driver.run();
+                stores[i]->sync();
+            } catch (std::exception const& err) {
+                errors[i] = err.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (md::index job = 1; job < jobs; job++) {
+        workers.emplace_back(run_replicas);
+    }
+    run_replicas();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Stores are closed here, after all the jobs have finished.
+    stores.clear();
+
+    int status = 0;
+    for (std::size_t i = 0; i < filenames.size(); i++) {
+        if (!errors[i].empty()) {
+            std::cerr << "error: " << filenames[i] << ": " << errors[i] << '\n';
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -3,25 +3,70 @@
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <string>
 #include <vector>
 
+#include <getopt.h>
+
 #include <md.hpp>
 
+#include "../simulation_common/profiler.hpp"
 #include "../simulation_common/simulation_store.hpp"
 
 #include "simulation_driver.hpp"
 
 
+namespace
+{
+    char const* const usage =
+        "usage: simulation_fine_sampling [-i isa] [-p profile] [-P] <trajectory>\n";
+
+    option const long_options[] = {
+        {"isa",           required_argument, nullptr, 'i'},
+        {"profile",       required_argument, nullptr, 'p'},
+        {"profile-store", no_argument,       nullptr, 'P'},
+        {nullptr,         0,                 nullptr, 0  },
+    };
+}
+
+
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
-        std::cerr << "usage: simulation_fine_sampling <trajectory>\n";
+    profile_options profile;
+    std::string isa = "sse";
+
+    for (int opt; (opt = getopt_long(argc, argv, "i:p:P", long_options, nullptr)) != -1; ) {
+        switch (opt) {
+        case 'i':
+            isa = optarg;
+            break;
+
+        case 'p':
+            profile.filename = optarg;
+            break;
+
+        case 'P':
+            profile.save_to_store = true;
+            break;
+
+        default:
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1) {
+        std::cerr << usage;
         return 1;
     }
 
-    simulation_store store{argv[1]};
-    simulation_driver driver{store};
+    simulation_store store{argv[0]};
+    simulation_driver driver{store, profile, isa};
     driver.run();
+    store.sync();
 
     return 0;
 }
@@ -12,11 +12,29 @@
 #include "simulation_driver.hpp"
 
 
-simulation_driver::simulation_driver(simulation_store& store)
+simulation_driver::simulation_driver(
+    simulation_store&      store,
+    profile_options const& profile,
+    std::string const&     isa
+)
     : _store{store}
     , _config{store.load_config()}
     , _random{_config.interphase_seed ^ 700000} // ?
+    , _simd_level{parse_simd_level(isa)}
+    , _profile_options{profile}
 {
+    if (_config.simulation_threads == 0) {
+        _config.simulation_threads = 1;
+    }
+    _workers = std::make_shared<worker_pool>(_config.simulation_threads);
+    _store.set_queue_size(_config.store_queue_size);
+    _store.set_position_format(_config.position_format);
+    _store.set_position_layout(_config.position_layout);
+
+    if (_profile_options.enabled()) {
+        _profiler = std::make_shared<profiler>();
+    }
+
     setup();
 }
 
@@ -57,7 +75,11 @@ void simulation_driver::setup_context()
 
 void simulation_driver::run()
 {
-    run_simulation();
+    {
+        profiler_scope scope{_profiler.get(), "run"};
+        run_simulation();
+    }
+    save_profile();
 }
 
 
@@ -88,6 +110,42 @@ void simulation_driver::print_progress(std::string phase, md::step step)
 }
 
 
+void simulation_driver::save_profile()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    if (!_profile_options.filename.empty()) {
+        _profiler->save(_profile_options.filename);
+    }
+    if (_profile_options.save_to_store) {
+        _store.save_profile("fine_sampling", _profiler->format_json());
+    }
+}
+
+
+void simulation_driver::request_energy(bool requested)
+{
+    if (_energy_monitor) {
+        _energy_monitor->set_requested(requested);
+    }
+}
+
+
+md::scalar simulation_driver::compute_mean_energy()
+{
+    // Use the energy computed along with the forces in the last step if it
+    // has been requested. Otherwise (e.g. at step 0) do a separate pass.
+    auto const energy =
+        _energy_monitor && _energy_monitor->is_available()
+        ? _energy_monitor->total_energy()
+        : _system.compute_energy();
+
+    return energy / static_cast<md::scalar>(_system.particle_count());
+}
+
+
 void simulation_driver::save_chains()
 {
     auto const chroms = _store.load_chromosomes();
@@ -1,19 +1,30 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <random>
+#include <string>
 
 #include <md.hpp>
 
+#include "../simulation_common/adaptive_dynamics.hpp"
+#include "../simulation_common/energy_monitor.hpp"
+#include "../simulation_common/profiler.hpp"
+#include "../simulation_common/simd_level.hpp"
 #include "../simulation_common/simulation_config.hpp"
 #include "../simulation_common/simulation_context.hpp"
 #include "../simulation_common/simulation_store.hpp"
+#include "../simulation_common/worker_pool.hpp"
 
 
 class simulation_driver
 {
 public:
-    explicit simulation_driver(simulation_store& store);
+    explicit simulation_driver(
+        simulation_store&      store,
+        profile_options const& profile = {},
+        std::string const&     isa = "sse"
+    );
     void run();
 
 private:
@@ -24,11 +35,16 @@ private:
     void setup_connectivity_forcefield();
     void setup_nucleolus_forcefield();
     void setup_membrane_forcefield();
+    void setup_energy_monitor();
     void setup_context();
 
     void run_simulation();
 
     void print_progress(std::string phase, md::step step);
+    void save_profile();
+
+    void request_energy(bool requested);
+    md::scalar compute_mean_energy();
 
     void update_wall_semiaxes();
 
@@ -41,5 +57,14 @@ private:
     md::system         _system;
     std::mt19937_64    _random;
 
+    std::shared_ptr<worker_pool>    _workers;
+    simd_level                      _simd_level;
+    std::shared_ptr<energy_monitor> _energy_monitor;
+
+    // Non-null if profiling is enabled.
+    profile_options           _profile_options;
+    std::shared_ptr<profiler> _profiler;
+
     std::function<md::vector()> _compute_packing_reaction;
+    adaptive_dynamics_stats     _dynamics_stats;
 };
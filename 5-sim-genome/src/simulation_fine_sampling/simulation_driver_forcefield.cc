@@ -1,16 +1,28 @@
 #include <algorithm>
+#include <memory>
+#include <stdexcept>
 
 #include <md.hpp>
 
+#include "../simulation_common/mixed_softcore_potential.hpp"
+#include "../simulation_common/parallel_pairwise_forcefield.hpp"
+
 #include "simulation_driver.hpp"
 
 
 void simulation_driver::setup_forcefield()
 {
+    if (_config.energy_method == "force_pass") {
+        _energy_monitor = std::make_shared<energy_monitor>();
+    } else if (_config.energy_method != "separate") {
+        throw std::runtime_error("unknown energy method: " + _config.energy_method);
+    }
+
     setup_repulsive_forcefield();
     setup_connectivity_forcefield();
     setup_nucleolus_forcefield();
     setup_membrane_forcefield();
+    setup_energy_monitor();
     setup_context();
 }
 
@@ -24,8 +36,12 @@ void simulation_driver::setup_repulsive_forcefield()
         _config.b_core_diameter
     );
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield(
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "repulsion",
+        make_parallel_neighbor_pairwise_forcefield(
+            _workers,
             [=](md::index i, md::index j) {
                 auto const data = _system.view(particle_data_attribute);
                 auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
@@ -40,12 +56,14 @@ void simulation_driver::setup_repulsive_forcefield()
                     .diameter = _config.b_core_diameter * _context.bead_scale
                 };
 
-                return a * a_potential + b * b_potential;
+                return mix_softcore_potentials(a, a_potential, b, b_potential);
             }
         )
         .set_neighbor_distance([=] {
             return max_diameter * _context.bead_scale;
         })
+        .set_simd_level(_simd_level)
+        .set_energy_monitor(_energy_monitor, "repulsion")
     );
 }
 
@@ -54,8 +72,12 @@ void simulation_driver::setup_connectivity_forcefield()
 {
     // Chromosome polymer connectivity.
 
-    auto chrom_bonds = _system.add_forcefield(
-        md::make_bonded_pairwise_forcefield(
+    auto chrom_bonds = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "chromatin_bond",
+        make_parallel_bonded_pairwise_forcefield(
+            _workers,
             [=](md::index, md::index) {
                 // The spring constant K corresponds to the inverse-variance of
                 // the fluctuation. If we scale the bond length, the fluctuation
@@ -69,6 +91,8 @@ void simulation_driver::setup_connectivity_forcefield()
                 };
             }
         )
+        .set_simd_level(_simd_level)
+        .set_energy_monitor(_energy_monitor, "chromatin_bond")
     );
 
     for (auto const& chrom : _store.load_chromosomes()) {
@@ -81,8 +105,12 @@ void simulation_driver::setup_nucleolus_forcefield()
 {
     // Nucleolar "sidechains" attached to active NORs.
 
-    auto nucleo_bonds = _system.add_forcefield(
-        md::make_bonded_pairwise_forcefield(
+    auto nucleo_bonds = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "nucleolus_bond",
+        make_parallel_bonded_pairwise_forcefield(
+            _workers,
             [=](md::index, md::index) {
                 auto const s = _context.bond_scale;
                 auto const K = _config.nucleolus_bond_spring * (1 / (s * s));
@@ -93,6 +121,8 @@ void simulation_driver::setup_nucleolus_forcefield()
                 };
             }
         )
+        .set_simd_level(_simd_level)
+        .set_energy_monitor(_energy_monitor, "nucleolus_bond")
     );
 
     for (auto const& [nor, nuc] : _store.load_nucleolus_bonds()) {
@@ -112,18 +142,28 @@ void simulation_driver::setup_nucleolus_forcefield()
         }
     }
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield(
-            md::apply_cutoff(
-                md::softwell_potential<6> {
-                    .energy         = _config.nucleolus_droplet_energy,
-                    .decay_distance = _config.nucleolus_droplet_decay
-                },
-                _config.nucleolus_droplet_cutoff
-            )
+    auto const droplet_potential = md::apply_cutoff(
+        md::softwell_potential<6> {
+            .energy         = _config.nucleolus_droplet_energy,
+            .decay_distance = _config.nucleolus_droplet_decay
+        },
+        _config.nucleolus_droplet_cutoff
+    );
+
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "droplet",
+        make_parallel_neighbor_pairwise_forcefield(
+            _workers,
+            [=](md::index, md::index) {
+                return droplet_potential;
+            }
         )
         .set_neighbor_distance(_config.nucleolus_droplet_cutoff)
         .set_neighbor_targets(nucleolar_particles)
+        .set_simd_level(_simd_level)
+        .set_energy_monitor(_energy_monitor, "droplet")
     );
 }
 
@@ -140,7 +180,10 @@ void simulation_driver::setup_membrane_forcefield()
         };
     };
 
-    auto inward_forcefield = _system.add_forcefield(
+    auto inward_forcefield = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "wall_inward",
         md::make_ellipsoid_inward_forcefield(
             // Smaller particle can get closer to the wall than larger one. So
             // inner membrane should be aware of particle type.
@@ -158,7 +201,7 @@ void simulation_driver::setup_membrane_forcefield()
                     .diameter = _config.b_core_diameter / 2 * _context.bead_scale
                 };
 
-                return a * a_potential + b * b_potential;
+                return mix_softcore_potentials(a, a_potential, b, b_potential);
             }
         )
         .set_ellipsoid(set_ellipsoid)
@@ -167,7 +210,10 @@ void simulation_driver::setup_membrane_forcefield()
     // Particles are basically confined to nucleus by the inward forcefield.
     // However, some particles may go outside due to fluctuations or something.
     // This outward forcefield ensures confinement.
-    auto outward_forcefield = _system.add_forcefield(
+    auto outward_forcefield = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "wall_outward",
         md::make_ellipsoid_outward_forcefield(
             md::harmonic_potential {
                 .spring_constant = _config.wall_packing_spring
@@ -181,4 +227,20 @@ void simulation_driver::setup_membrane_forcefield()
         auto const outward = outward_forcefield->stats.axial_reaction;
         return inward + outward;
     };
+
+    // Walls are cheap. Just let the monitor compute their energies.
+    if (_energy_monitor) {
+        _energy_monitor->add_forcefield("wall_inward", inward_forcefield);
+        _energy_monitor->add_forcefield("wall_outward", outward_forcefield);
+    }
+}
+
+
+void simulation_driver::setup_energy_monitor()
+{
+    // The monitor forcefield completes energy computation. So it must be the
+    // last forcefield evaluated.
+    if (_energy_monitor) {
+        _system.add_forcefield(energy_monitor_forcefield{_energy_monitor});
+    }
 }
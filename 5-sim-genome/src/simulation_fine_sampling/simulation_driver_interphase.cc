@@ -9,8 +9,20 @@ void simulation_driver::run_simulation()
 {
     _store.set_phase("fine_sampling");
 
+    // Time is accumulated by the integrator if the timestep is adaptive.
+    _dynamics_stats = {};
+
+    auto const needs_energy = [=](md::step step) {
+        return
+            step % _config.interphase_logging_interval == 0 ||
+            step % _config.interphase_sampling_interval == 0;
+    };
+
     auto callback = [=](md::step step) {
-        _context.time = step * _config.interphase_timestep;
+        _context.time =
+            _config.interphase_spacestep > 0
+            ? _dynamics_stats.time
+            : step * _config.interphase_timestep;
 
         // Calculating energy is expensive. So update stats only when needed.
         auto const with_logging = step % _config.interphase_logging_interval == 0;
@@ -18,7 +30,8 @@ void simulation_driver::run_simulation()
         auto const sample_frame = step / _config.interphase_sampling_interval;
 
         if (with_logging || with_sampling) {
-            _context.mean_energy = _system.compute_energy() / _system.particle_count();
+            profiler_scope scope{_profiler.get(), "energy"};
+            _context.mean_energy = compute_mean_energy();
         }
 
         if (with_logging) {
@@ -26,23 +39,38 @@ void simulation_driver::run_simulation()
         }
 
         if (with_sampling) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_positions(step, _system.view_positions());
             _store.save_context(step, _context);
         }
 
-        update_wall_semiaxes();
+        // The adaptive timestep is known only after the first integration
+        // step, so the wall skips step 0 there. Fixed-timestep runs keep the
+        // wall step at step 0.
+        if (step > 0 || _config.interphase_spacestep == 0) {
+            update_wall_semiaxes();
+        }
+
+        request_energy(needs_energy(step + 1));
     };
 
     callback(0);
 
-    md::simulate_brownian_dynamics(_system, {
+    md::brownian_dynamics_config const config = {
         .temperature = _config.interphase_temperature,
         .timestep    = _config.interphase_timestep,
         .spacestep   = _config.interphase_spacestep,
         .steps       = _config.interphase_steps,
         .seed        = _random(),
         .callback    = callback
-    });
+    };
+
+    // Same integrator as simulation_interphase.
+    if (config.spacestep > 0) {
+        simulate_adaptive_brownian_dynamics(_system, config, _dynamics_stats);
+    } else {
+        md::simulate_brownian_dynamics(_system, config);
+    }
 }
 
 
@@ -54,6 +82,12 @@ void simulation_driver::update_wall_semiaxes()
     net_force += _compute_packing_reaction();
     net_force -= _config.wall_semiaxes_spring.hadamard(semiaxes);
 
+    // The wall moves by the same timestep as the particles.
+    auto const timestep =
+        _config.interphase_spacestep > 0
+        ? _dynamics_stats.timestep
+        : _config.interphase_timestep;
+
     // Simulate ad-hoc overdamped motion of the wall.
-    semiaxes += _config.interphase_timestep * _config.wall_mobility * net_force;
+    semiaxes += timestep * _config.wall_mobility * net_force;
 }
@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "../simulation_common/mixed_softcore_potential.hpp"
+#include "../simulation_common/particle_data.hpp"
+
+#include "ab_repulsion_table.hpp"
+
+
+void ab_repulsion_table::set_particles(md::array_view<particle_data const> particles)
+{
+    std::map<std::pair<md::scalar, md::scalar>, std::uint32_t> class_map;
+
+    _class_data.clear();
+    _classes.clear();
+    _classes.reserve(particles.size());
+
+    for (auto const& data : particles) {
+        auto const key = std::make_pair(data.a_factor, data.b_factor);
+        auto const [it, inserted] = class_map.insert({
+            key, static_cast<std::uint32_t>(_class_data.size())
+        });
+        if (inserted) {
+            _class_data.push_back(data);
+        }
+        _classes.push_back(it->second);
+    }
+
+    _class_count = _class_data.size();
+    rebuild();
+}
+
+
+void ab_repulsion_table::set_potentials(
+    a_potential_type const& a_potential, b_potential_type const& b_potential
+)
+{
+    _a_potential = a_potential;
+    _b_potential = b_potential;
+    rebuild();
+}
+
+
+void ab_repulsion_table::set_scale(md::scalar scale)
+{
+    if (scale == _scale) {
+        return;
+    }
+    _scale = scale;
+    rebuild();
+}
+
+
+md::index ab_repulsion_table::class_count() const
+{
+    return _class_count;
+}
+
+
+void ab_repulsion_table::rebuild()
+{
+    a_potential_type a_potential = _a_potential;
+    b_potential_type b_potential = _b_potential;
+    a_potential.diameter *= _scale;
+    b_potential.diameter *= _scale;
+
+    // Mix the potentials exactly the same way as the per-pair computation so
+    // that the cached potentials give bit-identical forces.
+    _table.clear();
+    _table.reserve(_class_count * _class_count);
+
+    for (auto const& data_i : _class_data) {
+        for (auto const& data_j : _class_data) {
+            auto const a = 0.5 * (data_i.a_factor + data_j.a_factor);
+            auto const b = 0.5 * (data_i.b_factor + data_j.b_factor);
+            _table.push_back(mix_softcore_potentials(a, a_potential, b, b_potential));
+        }
+    }
+}
+
+
+void ab_repulsion_lookup::set_order(md::array_view<md::index const> order)
+{
+    _ordered_classes.resize(order.size());
+    for (md::index k = 0; k < order.size(); k++) {
+        _ordered_classes[k] = _table->particle_class(order[k]);
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+// This module defines ab_repulsion_table class. The class caches mixed A/B
+// repulsive potentials so that pairwise forcefield does not need to look up
+// particle data nor construct potential objects for each pair.
+
+#include <cstdint>
+#include <vector>
+
+#include <md.hpp>
+
+#include "../simulation_common/mixed_softcore_potential.hpp"
+#include "../simulation_common/particle_data.hpp"
+
+
+// Class: ab_repulsion_table
+//
+// Groups particles having the same (a_factor, b_factor) into a class and
+// caches the mixed A/B repulsive potential for every pair of the classes.
+//
+class ab_repulsion_table
+{
+public:
+    using a_potential_type = md::softcore_potential<2, 3>;
+    using b_potential_type = md::softcore_potential<8, 3>;
+    using potential_type = mixed_softcore_potential<2, 3, 8, 3>;
+
+    // Function: set_particles
+    //
+    // Classifies particles by their A/B factors.
+    //
+    void set_particles(md::array_view<particle_data const> particles);
+
+    // Function: set_potentials
+    //
+    // Sets the pure-A and pure-B potentials at the unit scale.
+    //
+    void set_potentials(a_potential_type const& a_potential, b_potential_type const& b_potential);
+
+    // Function: set_scale
+    //
+    // Scales the diameters of the potentials. The table is rebuilt only when
+    // the scale is changed since the last call.
+    //
+    void set_scale(md::scalar scale);
+
+    // Function: class_count
+    //
+    // Returns the number of distinct particle classes.
+    //
+    md::index class_count() const;
+
+    // Function: operator()
+    //
+    // Returns the cached potential for the pair of particles i and j.
+    //
+    potential_type const& operator()(md::index i, md::index j) const
+    {
+        return class_potential(_classes[i], _classes[j]);
+    }
+
+    // Function: particle_class
+    //
+    // Returns the class of particle i.
+    //
+    std::uint32_t particle_class(md::index i) const
+    {
+        return _classes[i];
+    }
+
+    // Function: class_potential
+    //
+    // Returns the cached potential for the pair of classes ci and cj.
+    //
+    potential_type const& class_potential(std::uint32_t ci, std::uint32_t cj) const
+    {
+        return _table[ci * _class_count + cj];
+    }
+
+private:
+    void rebuild();
+
+private:
+    a_potential_type            _a_potential;
+    b_potential_type            _b_potential;
+    md::scalar                  _scale = 1;
+    md::index                   _class_count = 0;
+    std::vector<particle_data>  _class_data;
+    std::vector<std::uint32_t>  _classes;
+    std::vector<potential_type> _table;
+};
+
+
+// Class: ab_repulsion_lookup
+//
+// Potential function of parallel pairwise forcefields looking up a table. It
+// supports ordered lookup (see has_ordered_lookup): set_order gathers the
+// classes of the particles into the order of the neighbor list so that the
+// lookups of the pairs in that order read the classes sequentially. The table
+// must outlive the lookup.
+//
+class ab_repulsion_lookup
+{
+public:
+    using potential_type = ab_repulsion_table::potential_type;
+
+    explicit ab_repulsion_lookup(ab_repulsion_table const& table)
+        : _table{&table}
+    {
+    }
+
+    potential_type const& operator()(md::index i, md::index j) const
+    {
+        return (*_table)(i, j);
+    }
+
+    // Function: set_order
+    //
+    // Gathers the classes of the particles in given order.
+    //
+    void set_order(md::array_view<md::index const> order);
+
+    // Function: ordered
+    //
+    // Returns the cached potential for the particles at places k and l in the
+    // order last passed to set_order.
+    //
+    potential_type const& ordered(md::index k, md::index l) const
+    {
+        return _table->class_potential(_ordered_classes[k], _ordered_classes[l]);
+    }
+
+private:
+    ab_repulsion_table const*  _table;
+    std::vector<std::uint32_t> _ordered_classes;
+};
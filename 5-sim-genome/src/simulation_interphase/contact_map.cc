@@ -1,15 +1,31 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <utility>
 #include <vector>
 
-#include <Eigen/Sparse>
 #include <md.hpp>
 
 #include "contact_map.hpp"
 
 
+namespace
+{
+    // Initial number of slots in the far-contact hash table. Must be a power
+    // of two.
+    constexpr std::size_t initial_far_capacity = std::size_t(1) << 16;
+
+    // Fibonacci hashing of packed index pairs.
+    inline std::size_t hash_key(std::uint64_t key, std::size_t mask)
+    {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15) >> 32) & mask;
+    }
+}
+
+
 void contact_map::set_contact_distance(md::scalar dist)
 {
     _contact_distance = dist;
@@ -22,70 +38,235 @@ md::scalar contact_map::contact_distance() const
 }
 
 
+void contact_map::set_distance_tolerance(md::scalar tol)
+{
+    _distance_tolerance = tol;
+}
+
+
+void contact_map::set_band_width(md::index width)
+{
+    _band_width = std::max(width, md::index(1));
+    _band.assign(_point_count * _band_width, 0);
+    clear();
+}
+
+
+void contact_map::set_map_enabled(bool enabled)
+{
+    _map_enabled = enabled;
+}
+
+
 void contact_map::clear()
 {
-    _contact_matrix.setZero();
+    std::fill(_band.begin(), _band.end(), Count(0));
+    std::fill(_far_keys.begin(), _far_keys.end(), _empty_key);
+    std::fill(_far_counts.begin(), _far_counts.end(), Count(0));
+    _far_size = 0;
 }
 
 
-void contact_map::update(md::array_view<const md::point> points)
+void contact_map::update(md::array_view<const md::point> points, contact_profile* profile)
 {
-    auto const matrix_dim = static_cast<Matrix::Index>(points.size());
-    if (_contact_matrix.rows() < matrix_dim) {
-        _contact_matrix.resize(matrix_dim, matrix_dim);
+    if (_map_enabled && _point_count < points.size()) {
+        resize(points.size());
     }
 
-    struct triplet_output_iterator
+    auto const dcut = _contact_distance;
+
+    // Keep the searcher and its cell storage while the contact distance stays
+    // within the tolerance. Pairs are filtered by the exact distance below.
+    if (!_searcher || dcut > _searcher_distance || dcut * (1 + 2 * _distance_tolerance) < _searcher_distance) {
+        _searcher_distance = dcut * (1 + _distance_tolerance);
+        _searcher.emplace(md::open_box{}, _searcher_distance);
+    }
+
+    struct contact_output_iterator
     {
-        std::vector<Triplet>& output;
+        contact_map&                    map;
+        md::array_view<md::point const> points;
+        md::scalar                      dcut2;
+        bool                            map_enabled;
+        contact_profile*                profile;
 
-        triplet_output_iterator operator++(int)
+        contact_output_iterator operator++(int)
         {
             return *this;
         }
 
-        triplet_output_iterator& operator*()
+        contact_output_iterator& operator*()
         {
             return *this;
         }
 
         void operator=(std::pair<md::index, md::index> const& pair)
         {
-            output.push_back({
-                static_cast<std::int32_t>(pair.first),
-                static_cast<std::int32_t>(pair.second),
-                1
-            });
+            auto const [i, j] = pair;
+            if ((points[i] - points[j]).squared_norm() < dcut2) {
+                if (map_enabled) {
+                    map.add_contact(i, j);
+                }
+                if (profile) {
+                    profile->add_contact(i, j);
+                }
+            }
         }
     };
 
-    _triplet_buffer.clear();
+    _searcher->set_points(points);
+    _searcher->search(contact_output_iterator{*this, points, dcut * dcut, _map_enabled, profile});
+}
 
-    md::neighbor_searcher<md::open_box> searcher{{}, _contact_distance};
-    searcher.set_points(points);
-    searcher.search(triplet_output_iterator{_triplet_buffer});
 
-    _matrix_buffer.resize(_contact_matrix.rows(), _contact_matrix.cols());
-    _matrix_buffer.setFromTriplets(_triplet_buffer.begin(), _triplet_buffer.end());
+void contact_map::update(
+    md::array_view<const md::point> points,
+    md::array_view<index_pair const> pairs,
+    contact_profile* profile
+)
+{
+    if (_map_enabled && _point_count < points.size()) {
+        resize(points.size());
+    }
 
-    _contact_matrix += _matrix_buffer;
+    auto const dcut2 = _contact_distance * _contact_distance;
+
+    for (auto const [i, j] : pairs) {
+        if ((points[i] - points[j]).squared_norm() < dcut2) {
+            if (_map_enabled) {
+                add_contact(i, j);
+            }
+            if (profile) {
+                profile->add_contact(i, j);
+            }
+        }
+    }
 }
 
 
 std::vector<std::array<std::uint32_t, 3>> contact_map::accumulate() const
 {
+    std::vector<std::pair<Key, Count>> far_contacts;
+    far_contacts.reserve(_far_size);
+
+    for (std::size_t slot = 0; slot < _far_keys.size(); slot++) {
+        if (_far_keys[slot] != _empty_key) {
+            far_contacts.emplace_back(_far_keys[slot], _far_counts[slot]);
+        }
+    }
+    std::sort(far_contacts.begin(), far_contacts.end());
+
     std::vector<std::array<std::uint32_t, 3>> contacts;
-    contacts.reserve(static_cast<std::size_t>(_contact_matrix.nonZeros()));
+    auto far_it = far_contacts.begin();
 
-    for (Matrix::Index i = 0; i < _contact_matrix.outerSize(); ++i) {
-        for (Matrix::InnerIterator it{_contact_matrix, i}; it; ++it) {
+    // In each row, band entries (j < i + width) precede far entries.
+    for (md::index i = 0; i < _point_count; i++) {
+        auto const row = _band.data() + i * _band_width;
+
+        for (md::index d = 1; d < _band_width; d++) {
+            if (row[d] != 0) {
+                contacts.push_back({
+                    static_cast<std::uint32_t>(i),
+                    static_cast<std::uint32_t>(i + d),
+                    row[d]
+                });
+            }
+        }
+
+        for (; far_it != far_contacts.end() && (far_it->first >> 32) == i; far_it++) {
             contacts.push_back({
-                static_cast<std::uint32_t>(it.row()),
-                static_cast<std::uint32_t>(it.col()),
-                it.value()
+                static_cast<std::uint32_t>(far_it->first >> 32),
+                static_cast<std::uint32_t>(far_it->first & 0xFFFFFFFF),
+                far_it->second
             });
         }
     }
 
     return contacts;
 }
+
+
+void contact_map::add_contacts(std::vector<std::array<std::uint32_t, 3>> const& contacts)
+{
+    for (auto const [i, j, count] : contacts) {
+        if (_point_count <= std::max(i, j)) {
+            resize(std::max(i, j) + 1);
+        }
+        add_contact(i, j, count);
+    }
+}
+
+
+void contact_map::resize(md::index point_count)
+{
+    // Keep existing counts: rows are laid out contiguously, so the band only
+    // needs to grow at the end.
+    _point_count = point_count;
+    _band.resize(_point_count * _band_width, 0);
+
+    if (_far_keys.empty()) {
+        _far_keys.assign(initial_far_capacity, _empty_key);
+        _far_counts.assign(initial_far_capacity, 0);
+    }
+}
+
+
+void contact_map::add_contact(md::index i, md::index j, Count count)
+{
+    if (i > j) {
+        std::swap(i, j);
+    }
+
+    if (j - i < _band_width) {
+        _band[i * _band_width + (j - i)] += count;
+    } else {
+        add_far_contact(Key(i) << 32 | Key(j), count);
+    }
+}
+
+
+void contact_map::add_far_contact(Key key, Count count)
+{
+    // Keep the load factor at most 1/2 so that probe sequences stay short.
+    if (2 * (_far_size + 1) > _far_keys.size()) {
+        grow_far_table();
+    }
+
+    auto const mask = _far_keys.size() - 1;
+    auto slot = hash_key(key, mask);
+
+    while (_far_keys[slot] != key) {
+        if (_far_keys[slot] == _empty_key) {
+            _far_keys[slot] = key;
+            _far_size++;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    _far_counts[slot] += count;
+}
+
+
+void contact_map::grow_far_table()
+{
+    std::vector<Key> keys(std::max(2 * _far_keys.size(), initial_far_capacity), _empty_key);
+    std::vector<Count> counts(keys.size(), 0);
+    auto const mask = keys.size() - 1;
+
+    for (std::size_t old_slot = 0; old_slot < _far_keys.size(); old_slot++) {
+        auto const key = _far_keys[old_slot];
+        if (key == _empty_key) {
+            continue;
+        }
+
+        auto slot = hash_key(key, mask);
+        while (keys[slot] != _empty_key) {
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = key;
+        counts[slot] = _far_counts[old_slot];
+    }
+
+    _far_keys.swap(keys);
+    _far_counts.swap(counts);
+}
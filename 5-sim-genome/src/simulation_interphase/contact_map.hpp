@@ -3,25 +3,32 @@
 // This module defines the interface of contact_map class. The class computes
 // time-integrated contact map of moving points.
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <vector>
 
-#include <Eigen/Sparse>
-
 #include <md.hpp>
 
+#include "../simulation_common/neighbor_pair_list.hpp"
+
+#include "contact_profile.hpp"
+
 
 // Class: contact_map
 //
-// Accumulates time-integrated contact map of moving points.
+// Accumulates time-integrated contact map of moving points. Contacts between
+// points close in index (|i - j| < band width) are counted in a dense band,
+// which is where most polymer contacts are. Other contacts are counted in an
+// open-addressing hash table. Both are reused across updates, so an update
+// does not allocate memory once the table has grown large enough.
 //
 class contact_map
 {
     using Count = std::uint32_t;
-    using Matrix = Eigen::SparseMatrix<Count, Eigen::RowMajor, std::int32_t>;
-    using Triplet = Eigen::Triplet<Count, std::int32_t>;
+    using Key = std::uint64_t;
 
 public:
     // Function: set_contact_distance
@@ -36,6 +43,28 @@ public:
     //
     md::scalar contact_distance() const;
 
+    // Function: set_distance_tolerance
+    //
+    // Sets the relative tolerance of contact distance changes. The neighbor
+    // searcher is kept across updates and rebuilt only when the contact
+    // distance goes out of the tolerance.
+    //
+    void set_distance_tolerance(md::scalar tol);
+
+    // Function: set_band_width
+    //
+    // Sets the width of the dense diagonal band. This clears contact map.
+    //
+    void set_band_width(md::index width);
+
+    // Function: set_map_enabled
+    //
+    // Enables or disables counting contacts in the map. A disabled map stays
+    // empty and update only feeds the contacts to the profile, so a run that
+    // saves only contact profiles does not pay for the map. Default is true.
+    //
+    void set_map_enabled(bool enabled);
+
     // Function: clear
     //
     // Clears contact map in-place.
@@ -44,21 +73,62 @@ public:
 
     // function: update
     //
-    // Computes contact map of given points and adds to the ensemble.
+    // Computes contact map of given points and adds to the ensemble. The
+    // contacts are also added to profile if it is not null.
     //
-    void update(md::array_view<const md::point> points);
+    void update(md::array_view<const md::point> points, contact_profile* profile = nullptr);
+
+    // Function: update
+    //
+    // Same as above but takes candidate pairs from an existing neighbor
+    // list instead of searching. The list must cover the contact distance.
+    //
+    void update(
+        md::array_view<const md::point> points,
+        md::array_view<index_pair const> pairs,
+        contact_profile* profile = nullptr
+    );
 
     // Function: accumulate
     //
     // Returns (i,j,v)-style contact map where i and j are indices and v is the
-    // number of contacts.
+    // number of contacts. Entries are ordered by (i, j) and satisfy i < j.
     //
     std::vector<std::array<Count, 3>> accumulate() const;
 
+    // Function: add_contacts
+    //
+    // Adds (i,j,v)-style contacts, e.g. ones returned by accumulate, to the
+    // map. Used to restore a partially accumulated map from a checkpoint.
+    //
+    void add_contacts(std::vector<std::array<Count, 3>> const& contacts);
+
+private:
+    void resize(md::index point_count);
+    void add_contact(md::index i, md::index j, Count count = 1);
+    void add_far_contact(Key key, Count count);
+    void grow_far_table();
+
 private:
     md::scalar _contact_distance = 0;
-    Matrix     _contact_matrix;
+    md::scalar _distance_tolerance = 0;
+    md::index  _band_width = 64;
+    md::index  _point_count = 0;
+    bool       _map_enabled = true;
+
+    // Searcher is built with a cutoff slightly larger than the contact
+    // distance so that small changes of the distance do not invalidate it.
+    std::optional<md::neighbor_searcher<md::open_box>> _searcher;
+    md::scalar _searcher_distance = 0;
+
+    // _band[i * _band_width + (j - i)] counts contacts between i and j.
+    std::vector<Count> _band;
+
+    // Linear-probing hash table of contacts outside the band. Keys are packed
+    // (i, j) pairs and the empty slots have the key _empty_key.
+    std::vector<Key>   _far_keys;
+    std::vector<Count> _far_counts;
+    std::size_t        _far_size = 0;
 
-    std::vector<Triplet> _triplet_buffer;
-    Matrix               _matrix_buffer;
+    static constexpr Key _empty_key = ~Key(0);
 };
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <md.hpp>
+
+#include "contact_profile.hpp"
+
+
+void contact_profile::set_particles(
+    md::array_view<chromosome_range const> chromosomes,
+    md::array_view<index_range const> nucleolus_ranges,
+    md::index point_count
+)
+{
+    _labels.assign(point_count, other_label);
+    _max_distance = 0;
+
+    for (md::index chrom = 0; chrom < chromosomes.size(); chrom++) {
+        auto const& range = chromosomes[chrom];
+        for (md::index i = range.start; i < range.end; i++) {
+            _labels[i] = static_cast<std::int32_t>(chrom);
+        }
+        _max_distance = std::max(_max_distance, range.end - range.start);
+    }
+
+    for (auto const& range : nucleolus_ranges) {
+        for (md::index i = range.begin; i < range.end; i++) {
+            _labels[i] = nucleolus_label;
+        }
+    }
+
+    _data.chromosome_count = chromosomes.size();
+    _data.distance_counts.assign(chromosomes.size() * _max_distance, 0);
+    _data.nucleolus_counts.assign(point_count, 0);
+}
+
+
+void contact_profile::clear()
+{
+    std::fill(_data.distance_counts.begin(), _data.distance_counts.end(), 0);
+    std::fill(_data.nucleolus_counts.begin(), _data.nucleolus_counts.end(), 0);
+}
+
+
+contact_profile_data const& contact_profile::data() const
+{
+    return _data;
+}
+
+
+void contact_profile::restore(
+    std::vector<std::uint32_t> const& distance_counts,
+    std::vector<std::uint32_t> const& nucleolus_counts
+)
+{
+    if (distance_counts.empty() && nucleolus_counts.empty()) {
+        clear();
+        return;
+    }
+
+    if (distance_counts.size() != _data.distance_counts.size() ||
+        nucleolus_counts.size() != _data.nucleolus_counts.size()) {
+        throw std::runtime_error("checkpoint does not match the contact profile");
+    }
+
+    _data.distance_counts = distance_counts;
+    _data.nucleolus_counts = nucleolus_counts;
+}
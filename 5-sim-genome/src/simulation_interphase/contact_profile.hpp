@@ -0,0 +1,93 @@
+#pragma once
+
+// This module defines the interface of contact_profile class. The class
+// accumulates small reductions of contacts, namely the contact frequency over
+// genomic distance and the nucleolus contacts of chromatin particles, which
+// are otherwise computed from saved contact maps after the fact.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <md.hpp>
+
+#include "../simulation_common/simulation_store.hpp"
+
+
+// Class: contact_profile
+//
+// Accumulates per-chromosome histograms of intra-chromosome contacts over
+// genomic distance and per-particle counts of contacts with nucleolar
+// particles. contact_map feeds the contacts it counts to this class.
+//
+class contact_profile
+{
+public:
+    // Function: set_particles
+    //
+    // Sets the chromosome and nucleolus ranges of the particles. This clears
+    // the profile.
+    //
+    void set_particles(
+        md::array_view<chromosome_range const> chromosomes,
+        md::array_view<index_range const> nucleolus_ranges,
+        md::index point_count
+    );
+
+    // Function: clear
+    //
+    // Clears the profile in-place.
+    //
+    void clear();
+
+    // Function: add_contact
+    //
+    // Counts a contact between particles i and j.
+    //
+    void add_contact(md::index i, md::index j)
+    {
+        if (i > j) {
+            std::swap(i, j);
+        }
+
+        auto const label_i = _labels[i];
+        auto const label_j = _labels[j];
+
+        if (label_i >= 0) {
+            if (label_i == label_j) {
+                _data.distance_counts[md::index(label_i) * _max_distance + (j - i)]++;
+            } else if (label_j == nucleolus_label) {
+                _data.nucleolus_counts[i]++;
+            }
+        } else if (label_i == nucleolus_label && label_j >= 0) {
+            _data.nucleolus_counts[j]++;
+        }
+    }
+
+    // Function: data
+    //
+    // Returns the profile accumulated since the last clear.
+    //
+    contact_profile_data const& data() const;
+
+    // Function: restore
+    //
+    // Replaces the profile with the counts saved in a checkpoint. Empty counts
+    // clear the profile. Throws std::runtime_error if the counts do not match
+    // the particles.
+    //
+    void restore(
+        std::vector<std::uint32_t> const& distance_counts,
+        std::vector<std::uint32_t> const& nucleolus_counts
+    );
+
+private:
+    // _labels[i] is the index of the chromosome containing particle i, or
+    // one of these negative labels.
+    static constexpr std::int32_t nucleolus_label = -1;
+    static constexpr std::int32_t other_label = -2;
+
+    std::vector<std::int32_t> _labels;
+    md::index                 _max_distance = 0;
+    contact_profile_data      _data;
+};
@@ -1,27 +1,104 @@
 #include <cassert>
 #include <ctime>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <string>
 #include <vector>
 
+#include <getopt.h>
+
 #include <md.hpp>
 
+#include "../simulation_common/command_line.hpp"
 #include "../simulation_common/simulation_store.hpp"
 
 #include "simulation_driver.hpp"
 
 
+namespace
+{
+    char const* const usage =
+        "usage: simulation_interphase [-t threads] [-c checkpoint] [--resume]"
+        " [-i isa] [-p profile] [--profile-store] <trajectory>\n";
+
+    option const long_options[] = {
+        {"threads",       required_argument, nullptr, 't'},
+        {"checkpoint",    required_argument, nullptr, 'c'},
+        {"resume",        no_argument,       nullptr, 'r'},
+        {"isa",           required_argument, nullptr, 'i'},
+        {"profile",       required_argument, nullptr, 'p'},
+        {"profile-store", no_argument,       nullptr, 'P'},
+        {nullptr,         0,                 nullptr, 0  },
+    };
+}
+
+
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
-        std::cerr << "usage: simulation_interphase <trajectory>\n";
+    driver_options options;
+
+    for (int opt; (opt = getopt_long(argc, argv, "t:c:ri:p:P", long_options, nullptr)) != -1; ) {
+        switch (opt) {
+        case 't': {
+            md::index threads;
+            if (!parse_index(optarg, threads)) {
+                std::cerr << usage;
+                return 1;
+            }
+            options.threads = threads;
+            break;
+        }
+
+        case 'c':
+            options.checkpoint_filename = optarg;
+            break;
+
+        case 'r':
+            options.resume = true;
+            break;
+
+        case 'i':
+            options.isa = optarg;
+            break;
+
+        case 'p':
+            options.profile.filename = optarg;
+            break;
+
+        case 'P':
+            options.profile.save_to_store = true;
+            break;
+
+        default:
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1) {
+        std::cerr << usage;
         return 1;
     }
 
-    simulation_store store{argv[1]};
-    simulation_driver driver{store};
-    driver.run();
+    // Checkpoint defaults to a file next to the trajectory.
+    if (options.checkpoint_filename.empty()) {
+        options.checkpoint_filename = std::string(argv[0]) + ".checkpoint";
+    }
+
+    try {
+        simulation_store store{argv[0]};
+        simulation_driver driver{store, options};
+        driver.run();
+        store.sync();
+    } catch (std::exception const& err) {
+        std::cerr << "error: " << err.what() << '\n';
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <md.hpp>
+
+#include "simulation_checkpoint.hpp"
+
+
+namespace
+{
+    // File signature. The last character is the format version. Version 1
+    // lacks the contact profile.
+    constexpr char checkpoint_signature[8] = {'G', 'D', 'C', 'K', 'P', 'T', '\0', '2'};
+    constexpr char checkpoint_version_1 = '1';
+
+    template<typename T>
+    void write_value(std::ostream& out, T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.write(reinterpret_cast<char const*>(&value), sizeof value);
+    }
+
+    template<typename T>
+    void write_vector(std::ostream& out, std::vector<T> const& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write_value(out, std::uint64_t(values.size()));
+        out.write(
+            reinterpret_cast<char const*>(values.data()),
+            static_cast<std::streamsize>(values.size() * sizeof(T))
+        );
+    }
+
+    void write_string(std::ostream& out, std::string const& str)
+    {
+        write_vector(out, std::vector<char>(str.begin(), str.end()));
+    }
+
+    template<typename T>
+    void read_value(std::istream& in, T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof value)) {
+            throw std::runtime_error("truncated checkpoint");
+        }
+    }
+
+    template<typename T>
+    void read_vector(std::istream& in, std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::uint64_t size;
+        read_value(in, size);
+        values.resize(size);
+        if (!in.read(
+            reinterpret_cast<char*>(values.data()),
+            static_cast<std::streamsize>(values.size() * sizeof(T))
+        )) {
+            throw std::runtime_error("truncated checkpoint");
+        }
+    }
+
+    void read_string(std::istream& in, std::string& str)
+    {
+        std::vector<char> chars;
+        read_vector(in, chars);
+        str.assign(chars.begin(), chars.end());
+    }
+}
+
+
+void save_checkpoint(std::string const& filename, simulation_checkpoint const& checkpoint)
+{
+    auto const temp_filename = filename + ".tmp";
+    {
+        std::ofstream out{temp_filename, std::ios::binary | std::ios::trunc};
+        if (!out) {
+            throw std::runtime_error("cannot create checkpoint file: " + temp_filename);
+        }
+
+        auto const& context = checkpoint.context;
+
+        out.write(checkpoint_signature, sizeof checkpoint_signature);
+        write_string(out, checkpoint.phase);
+        write_value(out, checkpoint.step);
+        write_vector(out, checkpoint.positions);
+        write_value(out, context.time);
+        write_value(out, context.wall_semiaxes);
+        write_value(out, context.bead_scale);
+        write_value(out, context.bond_scale);
+        write_value(out, context.mean_energy);
+        write_value(out, context.wall_energy);
+        write_string(out, checkpoint.random_state);
+        write_vector(out, checkpoint.contacts);
+        write_vector(out, checkpoint.contact_distances);
+        write_vector(out, checkpoint.nucleolus_contacts);
+
+        if (!out.flush()) {
+            throw std::runtime_error("failed to write checkpoint file: " + temp_filename);
+        }
+    }
+
+    if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("failed to rename checkpoint file: " + temp_filename);
+    }
+}
+
+
+simulation_checkpoint load_checkpoint(std::string const& filename)
+{
+    std::ifstream in{filename, std::ios::binary};
+    if (!in) {
+        throw std::runtime_error("cannot open checkpoint file: " + filename);
+    }
+
+    std::array<char, sizeof checkpoint_signature> signature;
+    if (!in.read(signature.data(), signature.size()) ||
+        !std::equal(signature.begin(), signature.end() - 1, checkpoint_signature)) {
+        throw std::runtime_error("not a checkpoint file: " + filename);
+    }
+
+    auto const version = signature.back();
+    if (version != checkpoint_signature[7] && version != checkpoint_version_1) {
+        throw std::runtime_error("unsupported checkpoint version: " + filename);
+    }
+
+    simulation_checkpoint checkpoint;
+    auto& context = checkpoint.context;
+
+    read_string(in, checkpoint.phase);
+    read_value(in, checkpoint.step);
+    read_vector(in, checkpoint.positions);
+    read_value(in, context.time);
+    read_value(in, context.wall_semiaxes);
+    read_value(in, context.bead_scale);
+    read_value(in, context.bond_scale);
+    read_value(in, context.mean_energy);
+    read_value(in, context.wall_energy);
+    read_string(in, checkpoint.random_state);
+    read_vector(in, checkpoint.contacts);
+
+    if (version != checkpoint_version_1) {
+        read_vector(in, checkpoint.contact_distances);
+        read_vector(in, checkpoint.nucleolus_contacts);
+    }
+
+    return checkpoint;
+}
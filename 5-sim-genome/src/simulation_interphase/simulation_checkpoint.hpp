@@ -0,0 +1,46 @@
+#pragma once
+
+// This module defines simulation_checkpoint struct and functions to save and
+// load it. A checkpoint holds the full-precision state of an interrupted run,
+// which simulation_store does not keep (positions are quantized there).
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <md.hpp>
+
+#include "../simulation_common/simulation_context.hpp"
+
+
+// Structure: simulation_checkpoint
+//
+// State of the simulation at the end of a step.
+//
+struct simulation_checkpoint
+{
+    std::string                               phase;
+    md::step                                  step = 0;
+    std::vector<md::point>                    positions;
+    simulation_context                        context;
+    std::string                               random_state;
+    std::vector<std::array<std::uint32_t, 3>> contacts;
+    std::vector<std::uint32_t>                contact_distances;
+    std::vector<std::uint32_t>                nucleolus_contacts;
+};
+
+
+// Function: save_checkpoint
+//
+// Saves checkpoint to a binary file. The file is written to a temporary file
+// first and then renamed, so an existing checkpoint is never left broken.
+//
+void save_checkpoint(std::string const& filename, simulation_checkpoint const& checkpoint);
+
+
+// Function: load_checkpoint
+//
+// Loads checkpoint from a binary file saved by save_checkpoint.
+//
+simulation_checkpoint load_checkpoint(std::string const& filename);
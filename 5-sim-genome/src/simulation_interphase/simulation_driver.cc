@@ -1,9 +1,13 @@
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 #include <md.hpp>
 
@@ -12,10 +16,16 @@
 #include "simulation_driver.hpp"
 
 
-simulation_driver::simulation_driver(simulation_store& store)
+simulation_driver::simulation_driver(simulation_store& store, driver_options const& options)
     : _store{store}
     , _config{store.load_config()}
+    , _label{options.label}
     , _random{_config.interphase_seed}
+    , _metadata{options.metadata}
+    , _init_positions{options.init_positions}
+    , _simd_level{parse_simd_level(options.isa)}
+    , _profile_options{options.profile}
+    , _checkpoint_filename{options.checkpoint_filename}
 {
     // Fill default values. This is for compatibility with older simulation runs.
     auto set_default = [](auto& var, auto def) {
@@ -28,7 +38,30 @@ simulation_driver::simulation_driver(simulation_store& store)
     set_default(_config.b_core_bond_spring, _config.chromatin_bond_spring);
     set_default(_config.b_core_bond_length, _config.chromatin_bond_length);
 
+    if (options.threads) {
+        _config.simulation_threads = *options.threads;
+    }
+    set_default(_config.simulation_threads, md::index(1));
+
+    if (!_metadata) {
+        _metadata = std::make_shared<simulation_metadata const>(_store.load_metadata());
+    }
+
+    _workers = std::make_shared<worker_pool>(_config.simulation_threads);
+    _store.set_queue_size(_config.store_queue_size);
+    _store.set_position_format(_config.position_format);
+    _store.set_position_layout(_config.position_layout);
+    _store.set_contact_format(_config.contactmap_format);
+
+    if (_profile_options.enabled()) {
+        _profiler = std::make_shared<profiler>();
+    }
+
     setup();
+
+    if (options.resume) {
+        _resume_checkpoint = load_checkpoint(_checkpoint_filename);
+    }
 }
 
 
@@ -48,28 +81,163 @@ void simulation_driver::setup_context()
         .bead_scale    = _config.bead_scale_init,
         .bond_scale    = _config.bond_scale_init
     };
+    _repulsion_table.set_scale(_context.bead_scale);
+    _contact_map.set_band_width(_config.contactmap_band_width);
+    _contact_map.set_distance_tolerance(_config.contactmap_distance_tolerance);
+    _contact_map.set_map_enabled(_config.contactmap_thinning_rate > 0);
+    _contact_profile.set_particles(
+        _metadata->chromosomes, _metadata->nucleolus_ranges, _metadata->particles.size()
+    );
 }
 
 
 void simulation_driver::run()
 {
-    run_relaxation();
-    run_simulation();
+    {
+        profiler_scope scope{_profiler.get(), "run"};
+        run_relaxation();
+        run_simulation();
+    }
+    save_profile();
+}
+
+
+void simulation_driver::run_dynamics(
+    std::string const& phase, md::step start_step, md::brownian_dynamics_config config
+)
+{
+    auto const interval = _config.checkpoint_interval;
+
+    auto const simulate = [&](md::brownian_dynamics_config const& segment_config) {
+        if (segment_config.spacestep > 0) {
+            simulate_adaptive_brownian_dynamics(_system, segment_config, _dynamics_stats);
+        } else {
+            md::simulate_brownian_dynamics(_system, segment_config);
+        }
+    };
+
+    if (interval == 0) {
+        config.seed = _random();
+        simulate(config);
+        return;
+    }
+
+    // Split the run into segments ending at multiples of the checkpoint
+    // interval. Each segment seeds the integrator from _random, so the state
+    // of _random saved in a checkpoint determines the rest of the run.
+    auto const last_step = config.steps;
+    auto const callback = config.callback;
+
+    for (auto step = start_step; step < last_step; ) {
+        auto const segment_start = step;
+        auto const segment_end = std::min(step - step % interval + interval, last_step);
+
+        config.steps = segment_end - segment_start;
+        config.seed = _random();
+        config.callback = [&](md::step segment_step) {
+            callback(segment_start + segment_step);
+        };
+        simulate(config);
+
+        step = segment_end;
+        write_checkpoint(phase, step);
+    }
+}
+
+
+void simulation_driver::write_checkpoint(std::string const& phase, md::step step)
+{
+    if (_checkpoint_filename.empty()) {
+        throw std::runtime_error("checkpoint filename is not specified");
+    }
+
+    profiler_scope scope{_profiler.get(), "checkpoint"};
+
+    // Snapshots up to this step must be in the file before the checkpoint
+    // tells that the step is done.
+    _store.sync();
+
+    simulation_checkpoint checkpoint;
+    checkpoint.phase = phase;
+    checkpoint.step = step;
+    checkpoint.context = _context;
+    checkpoint.contacts = _contact_map.accumulate();
+    checkpoint.contact_distances = _contact_profile.data().distance_counts;
+    checkpoint.nucleolus_contacts = _contact_profile.data().nucleolus_counts;
+
+    auto const positions = _system.view_positions();
+    checkpoint.positions.assign(positions.begin(), positions.end());
+
+    std::ostringstream random_state;
+    random_state << _random;
+    checkpoint.random_state = random_state.str();
+
+    save_checkpoint(_checkpoint_filename, checkpoint);
+
+    // Force computation sums pair forces in the order of the neighbor lists,
+    // which depends on where the lists were last built. Rebuild them now as a
+    // resumed run does, so that both runs produce identical trajectories.
+    if (_repulsion_pairs) {
+        _repulsion_pairs->invalidate();
+    }
+    if (_droplet_pairs) {
+        _droplet_pairs->invalidate();
+    }
+
+    // Likewise, a resumed run evaluates the held forces afresh.
+    for (auto& forcefield : _slow_forcefields) {
+        forcefield->invalidate();
+    }
+}
+
+
+md::step simulation_driver::restore_checkpoint()
+{
+    auto const checkpoint = std::move(*_resume_checkpoint);
+    _resume_checkpoint.reset();
+
+    auto positions = _system.view_positions();
+    if (checkpoint.positions.size() != positions.size()) {
+        throw std::runtime_error("checkpoint does not match the number of particles");
+    }
+    std::copy(checkpoint.positions.begin(), checkpoint.positions.end(), positions.begin());
+
+    std::istringstream random_state{checkpoint.random_state};
+    random_state >> _random;
+    if (!random_state) {
+        throw std::runtime_error("checkpoint has invalid random state");
+    }
+
+    _context = checkpoint.context;
+    _repulsion_table.set_scale(_context.bead_scale);
+    _contact_map.clear();
+    _contact_map.add_contacts(checkpoint.contacts);
+    _contact_profile.restore(checkpoint.contact_distances, checkpoint.nucleolus_contacts);
+
+    std::clog << _label << "resuming " << checkpoint.phase << " from step " << checkpoint.step << '\n';
+
+    return checkpoint.step;
 }
 
 
 void simulation_driver::print_progress(std::string phase, md::step step)
 {
+    // std::localtime returns a shared buffer, which races with concurrent
+    // drivers in simulation_ensemble.
     auto const wallclock_time = std::time(nullptr);
+    std::tm local_time;
+    localtime_r(&wallclock_time, &local_time);
     auto const effective_radius = std::cbrt(
         _context.wall_semiaxes.x *
         _context.wall_semiaxes.y *
         _context.wall_semiaxes.z
     );
 
-    std::clog
+    std::ostringstream line;
+    line
+        << _label
         << "[" + phase + "] "
-        << std::put_time(std::localtime(&wallclock_time), "%F %T")
+        << std::put_time(&local_time, "%F %T")
         << '\t'
         << step
         << '\t'
@@ -80,13 +248,88 @@ void simulation_driver::print_progress(std::string phase, md::step step)
         << effective_radius
         << '\t'
         << "E: "
-        << _context.mean_energy
-        << '\n';
+        << _context.mean_energy;
+
+    if (_repulsion_pairs) {
+        line
+            << '\t'
+            << "rebuilds: "
+            << _repulsion_pairs->rebuild_count();
+    }
+
+    // Fraction of the steps shortened by the spacestep, and the timestep of
+    // the last step. Only for phases running with a positive spacestep.
+    if (_dynamics_stats.steps > 0) {
+        auto const limited_ratio =
+            static_cast<md::scalar>(_dynamics_stats.limited_steps) /
+            static_cast<md::scalar>(_dynamics_stats.steps);
+        line
+            << '\t'
+            << "limited: "
+            << limited_ratio
+            << '\t'
+            << "dt: "
+            << _dynamics_stats.timestep;
+    }
+
+    if (_energy_monitor && _energy_monitor->is_available()) {
+        auto const& names = _energy_monitor->names();
+        auto const& energies = _energy_monitor->energies();
+        for (std::size_t i = 0; i < names.size(); i++) {
+            line << '\t' << names[i] << ": " << energies[i];
+        }
+    }
+    line << '\n';
+
+    // Write the line at once so that lines from concurrent drivers do not mix.
+    std::clog << line.str();
+}
+
+
+void simulation_driver::save_profile()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    if (_repulsion_pairs) {
+        _profiler->set_count("repulsion_list_rebuilds", _repulsion_pairs->rebuild_count());
+    }
+    if (_droplet_pairs) {
+        _profiler->set_count("droplet_list_rebuilds", _droplet_pairs->rebuild_count());
+    }
+
+    if (!_profile_options.filename.empty()) {
+        _profiler->save(_profile_options.filename);
+    }
+    if (_profile_options.save_to_store) {
+        _store.save_profile("interphase", _profiler->format_json());
+    }
+}
+
+
+void simulation_driver::request_energy(bool requested)
+{
+    if (_energy_monitor) {
+        _energy_monitor->set_requested(requested);
+    }
+}
+
+
+md::scalar simulation_driver::compute_mean_energy()
+{
+    // Use the energy computed along with the forces in the last step if it
+    // has been requested. Otherwise (e.g. at step 0) do a separate pass.
+    auto const energy =
+        _energy_monitor && _energy_monitor->is_available()
+        ? _energy_monitor->total_energy()
+        : _system.compute_energy();
+
+    return energy / static_cast<md::scalar>(_system.particle_count());
 }
 
 
 void simulation_driver::save_chains()
 {
-    auto const chroms = _store.load_chromosomes();
-    _store.save_chromosomes(chroms);
+    _store.save_chromosomes(_metadata->chromosomes);
 }
@@ -1,21 +1,66 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <optional>
 #include <random>
+#include <string>
+#include <vector>
 
 #include <md.hpp>
 
+#include "../simulation_common/adaptive_dynamics.hpp"
+#include "../simulation_common/energy_monitor.hpp"
+#include "../simulation_common/multiple_timestep_forcefield.hpp"
+#include "../simulation_common/neighbor_pair_list.hpp"
+#include "../simulation_common/profiler.hpp"
+#include "../simulation_common/simd_level.hpp"
 #include "../simulation_common/simulation_config.hpp"
 #include "../simulation_common/simulation_context.hpp"
 #include "../simulation_common/simulation_store.hpp"
+#include "../simulation_common/worker_pool.hpp"
 
+#include "ab_repulsion_table.hpp"
 #include "contact_map.hpp"
+#include "contact_profile.hpp"
+#include "simulation_checkpoint.hpp"
+
+
+// Struct: driver_options
+//
+// Command-line overrides of the configuration stored in the trajectory file.
+//
+struct driver_options
+{
+    std::optional<md::index> threads;
+
+    // Metadata shared among replicas. Loaded from the store if null.
+    std::shared_ptr<simulation_metadata const> metadata;
+
+    // Initial positions of the relaxation phase. Loaded from the store if
+    // null. simulation_pipeline passes the refined spindle conformation here.
+    std::shared_ptr<std::vector<md::point> const> init_positions;
+
+    // Prefix of progress messages. Used to tell replicas apart.
+    std::string label;
+
+    // Checkpoints are saved to this file. Resume continues the run from the
+    // checkpoint saved in the file.
+    std::string checkpoint_filename;
+    bool        resume = false;
+
+    // Per-forcefield timings and counters are saved if enabled.
+    profile_options profile;
+
+    // Instruction set of the pair kernels. See parse_simd_level.
+    std::string isa = "sse";
+};
 
 
 class simulation_driver
 {
 public:
-    explicit simulation_driver(simulation_store& store);
+    explicit simulation_driver(simulation_store& store, driver_options const& options = {});
     void run();
 
 private:
@@ -27,12 +72,29 @@ private:
     void setup_loop_forcefield();
     void setup_nucleolus_forcefield();
     void setup_membrane_forcefield();
+    void setup_energy_monitor();
     void setup_context();
+    void add_slow_forcefield(std::string const& name, std::shared_ptr<md::forcefield> forcefield);
+
+    template<typename PairPotential, typename AddBonds>
+    void add_bonded_forcefield(
+        std::string const& name, PairPotential const& pair_potential, AddBonds add_bonds
+    );
 
     void run_relaxation();
     void run_simulation();
+    void run_dynamics(
+        std::string const& phase, md::step start_step, md::brownian_dynamics_config config
+    );
+
+    void write_checkpoint(std::string const& phase, md::step step);
+    md::step restore_checkpoint();
 
     void print_progress(std::string phase, md::step step);
+    void save_profile();
+
+    void request_energy(bool requested);
+    md::scalar compute_mean_energy();
 
     void update_bead_scale();
     void update_wall_semiaxes();
@@ -42,10 +104,47 @@ private:
 private:
     simulation_store&  _store;
     simulation_config  _config;
+    std::string        _label;
     simulation_context _context;
     contact_map        _contact_map;
+    contact_profile    _contact_profile;
+    ab_repulsion_table _repulsion_table;
     md::system         _system;
     std::mt19937_64    _random;
 
+    std::shared_ptr<simulation_metadata const>    _metadata;
+    std::shared_ptr<std::vector<md::point> const> _init_positions;
+    std::shared_ptr<worker_pool>                  _workers;
+    simd_level                                    _simd_level;
+
+    // True if pairwise forcefields are the serial micromd ones. See
+    // setup_forcefield.
+    bool _serial_forcefields = false;
+
+    // Non-null if profiling is enabled.
+    profile_options           _profile_options;
+    std::shared_ptr<profiler> _profiler;
+
+    // Neighbor list of the repulsion forcefield. Also used by the contact map
+    // if contactmap_search is "shared". Null if _serial_forcefields is true.
+    std::shared_ptr<neighbor_pair_list> _repulsion_pairs;
+    std::function<md::scalar()>         _repulsion_distance;
+    std::shared_ptr<neighbor_pair_list> _droplet_pairs;
+
+    // Neighbor pairwise forcefields evaluated every interphase_repulsion_interval
+    // steps in the interphase phase and every step in the relaxation phase.
+    std::vector<std::shared_ptr<multiple_timestep_forcefield>> _slow_forcefields;
+
+    // Statistics of the current phase. Updated if the phase runs with a
+    // positive spacestep.
+    adaptive_dynamics_stats _dynamics_stats;
+
+    std::string                          _checkpoint_filename;
+    std::optional<simulation_checkpoint> _resume_checkpoint;
+
+    // Collects energies in force evaluations if energy_method is "force_pass".
+    // Null otherwise.
+    std::shared_ptr<energy_monitor> _energy_monitor;
+
     std::function<md::vector()> _compute_packing_reaction;
 };
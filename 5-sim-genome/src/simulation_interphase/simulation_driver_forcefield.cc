@@ -1,17 +1,52 @@
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 #include <md.hpp>
 
+#include "../simulation_common/mixed_softcore_potential.hpp"
+#include "../simulation_common/parallel_pairwise_forcefield.hpp"
+
 #include "simulation_driver.hpp"
 
 
+namespace
+{
+    template<typename T>
+    std::shared_ptr<T> copy_shared(T const& obj)
+    {
+        return std::make_shared<T>(obj);
+    }
+}
+
+
 void simulation_driver::setup_forcefield()
 {
+    if (_config.energy_method == "force_pass") {
+        _energy_monitor = std::make_shared<energy_monitor>();
+    } else if (_config.energy_method != "separate") {
+        throw std::runtime_error("unknown energy method: " + _config.energy_method);
+    }
+
+    // A single-threaded run not using the pair list features keeps the serial
+    // micromd forcefields. Their trajectories differ in rounding from those of
+    // the parallel forcefields, which sum pair forces in another order.
+    _serial_forcefields =
+        _config.simulation_threads == 1 &&
+        _config.neighbor_skin == 0 &&
+        _config.neighbor_reorder_interval == 0 &&
+        _config.contactmap_search == "separate" &&
+        !_energy_monitor;
+
     setup_repulsive_forcefield();
     setup_connectivity_forcefield();
     setup_loop_forcefield();
     setup_nucleolus_forcefield();
     setup_membrane_forcefield();
+    setup_energy_monitor();
     setup_context();
 }
 
@@ -25,29 +60,107 @@ void simulation_driver::setup_repulsive_forcefield()
         _config.b_core_diameter
     );
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield(
-            [=](md::index i, md::index j) {
-                auto const data = _system.view(particle_data_attribute);
-                auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
-                auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
+    std::function<md::scalar()> neighbor_distance = [=] {
+        return max_diameter * _context.bead_scale;
+    };
 
-                md::softcore_potential<2, 3> const a_potential {
-                    .energy   = _config.a_core_repulsion,
-                    .diameter = _config.a_core_diameter * _context.bead_scale
-                };
-                md::softcore_potential<8, 3> const b_potential {
-                    .energy   = _config.b_core_repulsion,
-                    .diameter = _config.b_core_diameter * _context.bead_scale
-                };
+    // Contacts may be taken from the repulsion neighbor list instead of a
+    // separate search. The list then needs to cover the contact distance.
+    if (_config.contactmap_search == "shared") {
+        // Without a skin the list is rebuilt on every contact update and
+        // every force evaluation, each time out to the contact distance.
+        if (_config.neighbor_skin <= 0) {
+            throw std::runtime_error("shared contact map search needs a positive neighbor_skin");
+        }
+        neighbor_distance = [=] {
+            auto const repulsion_distance = max_diameter * _context.bead_scale;
+            auto const contact_distance = _config.contactmap_distance * _context.bead_scale;
+            return std::max(repulsion_distance, contact_distance);
+        };
+    } else if (_config.contactmap_search != "separate") {
+        throw std::runtime_error("unknown contact map search: " + _config.contactmap_search);
+    }
+
+    _repulsion_distance = neighbor_distance;
+
+    // The serial forcefield takes pair_potential. The parallel one takes
+    // parallel_pair_potential, which may also provide ordered lookups.
+    auto add_repulsion = [&](auto pair_potential, auto parallel_pair_potential) {
+        if (_serial_forcefields) {
+            add_slow_forcefield(
+                "repulsion",
+                copy_shared(
+                    md::make_neighbor_pairwise_forcefield(pair_potential)
+                    .set_neighbor_distance(neighbor_distance)
+                )
+            );
+            return;
+        }
 
-                return a * a_potential + b * b_potential;
+        _repulsion_pairs = std::make_shared<neighbor_pair_list>();
+        _repulsion_pairs->set_skin(_config.neighbor_skin);
+        _repulsion_pairs->set_reorder_interval(_config.neighbor_reorder_interval);
+
+        add_slow_forcefield(
+            "repulsion",
+            copy_shared(
+                make_parallel_neighbor_pairwise_forcefield(_workers, parallel_pair_potential)
+                .set_neighbor_distance(neighbor_distance)
+                .set_neighbor_list(_repulsion_pairs)
+                .set_simd_level(_simd_level)
+                .set_energy_monitor(_energy_monitor, "repulsion")
+            )
+        );
+    };
+
+    if (_config.repulsion_method == "table") {
+        // Most particles fall into a few (a_factor, b_factor) classes. So,
+        // precompute potentials for each pair of the classes. The table is
+        // rebuilt when bead scale changes (see update_bead_scale).
+        _repulsion_table.set_particles(_system.view(particle_data_attribute));
+        _repulsion_table.set_potentials(
+            md::softcore_potential<2, 3> {
+                .energy   = _config.a_core_repulsion,
+                .diameter = _config.a_core_diameter
+            },
+            md::softcore_potential<8, 3> {
+                .energy   = _config.b_core_repulsion,
+                .diameter = _config.b_core_diameter
             }
-        )
-        .set_neighbor_distance([=] {
-            return max_diameter * _context.bead_scale;
-        })
-    );
+        );
+        _repulsion_table.set_scale(_context.bead_scale);
+
+        add_repulsion(
+            [=](md::index i, md::index j) {
+                return _repulsion_table(i, j);
+            },
+            ab_repulsion_lookup{_repulsion_table}
+        );
+        return;
+    }
+
+    if (_config.repulsion_method != "direct") {
+        throw std::runtime_error("unknown repulsion method: " + _config.repulsion_method);
+    }
+
+    auto const pair_potential = [=](md::index i, md::index j) {
+        auto const data = _system.view(particle_data_attribute);
+        auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
+        auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
+
+        md::softcore_potential<2, 3> const a_potential {
+            .energy   = _config.a_core_repulsion,
+            .diameter = _config.a_core_diameter * _context.bead_scale
+        };
+        md::softcore_potential<8, 3> const b_potential {
+            .energy   = _config.b_core_repulsion,
+            .diameter = _config.b_core_diameter * _context.bead_scale
+        };
+
+        return mix_softcore_potentials(a, a_potential, b, b_potential);
+    };
+
+    add_repulsion(pair_potential, pair_potential);
 }
 
 
@@ -55,37 +168,37 @@ void simulation_driver::setup_connectivity_forcefield()
 {
     // Chromosome polymer connectivity.
 
-    auto chrom_bonds = _system.add_forcefield(
-        md::make_bonded_pairwise_forcefield(
-            [=](md::index i, md::index j) {
-                auto const data = _system.view(particle_data_attribute);
-                auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
-                auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
-
-                // Bond parameters vary on the type of the bonded cores. Just
-                // mix the parameters if the types of the bonded cores are
-                // not the same.
-                auto const K = a * _config.a_core_bond_spring + b * _config.b_core_bond_spring;
-                auto const l = a * _config.a_core_bond_length + b * _config.b_core_bond_length;
-
-                // The spring constant K corresponds to the inverse-variance of
-                // the fluctuation. If we scale the bond length, the fluctuation
-                // should also be scaled.
-                auto const s = _context.bond_scale;
-                auto const scaled_K = K * (1 / (s * s));
-                auto const scaled_l = l * s;
-
-                return md::semispring_potential {
-                    .spring_constant      = scaled_K,
-                    .equilibrium_distance = scaled_l
-                };
+    add_bonded_forcefield(
+        "chromatin_bond",
+        [=](md::index i, md::index j) {
+            auto const data = _system.view(particle_data_attribute);
+            auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
+            auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
+
+            // Bond parameters vary on the type of the bonded cores. Just
+            // mix the parameters if the types of the bonded cores are
+            // not the same.
+            auto const K = a * _config.a_core_bond_spring + b * _config.b_core_bond_spring;
+            auto const l = a * _config.a_core_bond_length + b * _config.b_core_bond_length;
+
+            // The spring constant K corresponds to the inverse-variance of
+            // the fluctuation. If we scale the bond length, the fluctuation
+            // should also be scaled.
+            auto const s = _context.bond_scale;
+            auto const scaled_K = K * (1 / (s * s));
+            auto const scaled_l = l * s;
+
+            return md::semispring_potential {
+                .spring_constant      = scaled_K,
+                .equilibrium_distance = scaled_l
+            };
+        },
+        [&](auto& bonds) {
+            for (auto const& chrom : _metadata->chromosomes) {
+                bonds.add_bonded_range(chrom.start, chrom.end);
             }
-        )
+        }
     );
-
-    for (auto const& chrom : _store.load_chromosomes()) {
-        chrom_bonds->add_bonded_range(chrom.start, chrom.end);
-    }
 }
 
 
@@ -93,38 +206,38 @@ void simulation_driver::setup_loop_forcefield()
 {
     // Mean-field intra-TAD loops.
 
-    auto loop_bonds = _system.add_forcefield(
-        md::make_bonded_pairwise_forcefield(
-            [=](md::index i, md::index j) {
-                auto const data = _system.view(particle_data_attribute);
-                auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
-                auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
-
-                // Bond parameters vary on the type of the bonded cores. Just
-                // mix the parameters if the types of the bonded cores are
-                // not the same.
-                auto const K =
-                    a * _config.a_core_2nd_bond_spring +
-                    b * _config.b_core_2nd_bond_spring;
-
-                // The spring constant K corresponds to the inverse-variance of
-                // the fluctuation. If we scale the bond length, the fluctuation
-                // should also be scaled.
-                auto const s = _context.bond_scale;
-                auto const scaled_K = K * (1 / (s * s));
-
-                return md::harmonic_potential {
-                    .spring_constant = scaled_K
-                };
+    add_bonded_forcefield(
+        "loop",
+        [=](md::index i, md::index j) {
+            auto const data = _system.view(particle_data_attribute);
+            auto const a = 0.5 * (data[i].a_factor + data[j].a_factor);
+            auto const b = 0.5 * (data[i].b_factor + data[j].b_factor);
+
+            // Bond parameters vary on the type of the bonded cores. Just
+            // mix the parameters if the types of the bonded cores are
+            // not the same.
+            auto const K =
+                a * _config.a_core_2nd_bond_spring +
+                b * _config.b_core_2nd_bond_spring;
+
+            // The spring constant K corresponds to the inverse-variance of
+            // the fluctuation. If we scale the bond length, the fluctuation
+            // should also be scaled.
+            auto const s = _context.bond_scale;
+            auto const scaled_K = K * (1 / (s * s));
+
+            return md::harmonic_potential {
+                .spring_constant = scaled_K
+            };
+        },
+        [&](auto& bonds) {
+            for (auto const& chrom : _metadata->chromosomes) {
+                for (auto i = chrom.start; i + 2 < chrom.end; i++) {
+                    bonds.add_bonded_pair(i, i + 2);
+                }
             }
-        )
-    );
-
-    for (auto const& chrom : _store.load_chromosomes()) {
-        for (auto i = chrom.start; i + 2 < chrom.end; i++) {
-            loop_bonds->add_bonded_pair(i, i + 2);
         }
-    }
+    );
 }
 
 
@@ -132,24 +245,24 @@ void simulation_driver::setup_nucleolus_forcefield()
 {
     // Nucleolar "sidechains" attached to active NORs.
 
-    auto nucleo_bonds = _system.add_forcefield(
-        md::make_bonded_pairwise_forcefield(
-            [=](md::index, md::index) {
-                auto const s = _context.bond_scale;
-                auto const K = _config.nucleolus_bond_spring * (1 / (s * s));
-                auto const b = _config.nucleolus_bond_length * s;
-                return md::semispring_potential {
-                    .spring_constant      = K,
-                    .equilibrium_distance = b
-                };
+    add_bonded_forcefield(
+        "nucleolus_bond",
+        [=](md::index, md::index) {
+            auto const s = _context.bond_scale;
+            auto const K = _config.nucleolus_bond_spring * (1 / (s * s));
+            auto const b = _config.nucleolus_bond_length * s;
+            return md::semispring_potential {
+                .spring_constant      = K,
+                .equilibrium_distance = b
+            };
+        },
+        [&](auto& bonds) {
+            for (auto const& [nor, nuc] : _metadata->nucleolus_bonds) {
+                bonds.add_bonded_pair(nor, nuc);
             }
-        )
+        }
     );
 
-    for (auto const& [nor, nuc] : _store.load_nucleolus_bonds()) {
-        nucleo_bonds->add_bonded_pair(nor, nuc);
-    }
-
     // Nucleolar droplet-forming attractive interactions. This is expensive to
     // compute, so add only when interaction energy is set to nonzero.
     if (_config.nucleolus_droplet_energy == 0) {
@@ -157,24 +270,50 @@ void simulation_driver::setup_nucleolus_forcefield()
     }
 
     std::vector<md::index> nucleolar_particles;
-    for (auto const range : _store.load_nucleolus_ranges()) {
+    for (auto const range : _metadata->nucleolus_ranges) {
         for (md::index i = range.begin; i < range.end; i++) {
             nucleolar_particles.push_back(i);
         }
     }
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield(
-            md::apply_cutoff(
-                md::softwell_potential<6> {
-                    .energy         = _config.nucleolus_droplet_energy,
-                    .decay_distance = _config.nucleolus_droplet_decay
-                },
-                _config.nucleolus_droplet_cutoff
+    auto const droplet_potential = md::apply_cutoff(
+        md::softwell_potential<6> {
+            .energy         = _config.nucleolus_droplet_energy,
+            .decay_distance = _config.nucleolus_droplet_decay
+        },
+        _config.nucleolus_droplet_cutoff
+    );
+
+    if (_serial_forcefields) {
+        add_slow_forcefield(
+            "droplet",
+            copy_shared(
+                md::make_neighbor_pairwise_forcefield(droplet_potential)
+                .set_neighbor_distance(_config.nucleolus_droplet_cutoff)
+                .set_neighbor_targets(nucleolar_particles)
+            )
+        );
+        return;
+    }
+
+    _droplet_pairs = std::make_shared<neighbor_pair_list>();
+    _droplet_pairs->set_skin(_config.neighbor_skin);
+    _droplet_pairs->set_targets(nucleolar_particles);
+
+    add_slow_forcefield(
+        "droplet",
+        copy_shared(
+            make_parallel_neighbor_pairwise_forcefield(
+                _workers,
+                [=](md::index, md::index) {
+                    return droplet_potential;
+                }
             )
+            .set_neighbor_distance(_config.nucleolus_droplet_cutoff)
+            .set_neighbor_list(_droplet_pairs)
+            .set_simd_level(_simd_level)
+            .set_energy_monitor(_energy_monitor, "droplet")
         )
-        .set_neighbor_distance(_config.nucleolus_droplet_cutoff)
-        .set_neighbor_targets(nucleolar_particles)
     );
 }
 
@@ -191,7 +330,10 @@ void simulation_driver::setup_membrane_forcefield()
         };
     };
 
-    auto inward_forcefield = _system.add_forcefield(
+    auto inward_forcefield = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "wall_inward",
         md::make_ellipsoid_inward_forcefield(
             // Smaller particle can get closer to the wall than larger one. So
             // inner membrane should be aware of particle type.
@@ -209,7 +351,7 @@ void simulation_driver::setup_membrane_forcefield()
                     .diameter = _config.b_core_diameter / 2 * _context.bead_scale
                 };
 
-                return a * a_potential + b * b_potential;
+                return mix_softcore_potentials(a, a_potential, b, b_potential);
             }
         )
         .set_ellipsoid(set_ellipsoid)
@@ -218,7 +360,10 @@ void simulation_driver::setup_membrane_forcefield()
     // Particles are basically confined to nucleus by the inward forcefield.
     // However, some particles may go outside due to fluctuations or something.
     // This outward forcefield ensures confinement.
-    auto outward_forcefield = _system.add_forcefield(
+    auto outward_forcefield = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "wall_outward",
         md::make_ellipsoid_outward_forcefield(
             md::harmonic_potential {
                 .spring_constant = _config.wall_packing_spring
@@ -232,4 +377,65 @@ void simulation_driver::setup_membrane_forcefield()
         auto const outward = outward_forcefield->stats.axial_reaction;
         return inward + outward;
     };
+
+    // Walls are cheap. Just let the monitor compute their energies.
+    if (_energy_monitor) {
+        _energy_monitor->add_forcefield("wall_inward", inward_forcefield);
+        _energy_monitor->add_forcefield("wall_outward", outward_forcefield);
+    }
+}
+
+
+void simulation_driver::add_slow_forcefield(
+    std::string const& name, std::shared_ptr<md::forcefield> forcefield
+)
+{
+    // The forces are held between evaluations in the interphase phase. See
+    // run_simulation.
+    auto slow_forcefield = std::make_shared<multiple_timestep_forcefield>(std::move(forcefield));
+    slow_forcefield->set_energy_monitor(_energy_monitor, name);
+    _slow_forcefields.push_back(slow_forcefield);
+
+    add_profiled_forcefield(_system, _profiler, name, slow_forcefield);
+}
+
+
+template<typename PairPotential, typename AddBonds>
+void simulation_driver::add_bonded_forcefield(
+    std::string const& name, PairPotential const& pair_potential, AddBonds add_bonds
+)
+{
+    // add_bonds adds bonded pairs to the forcefield passed by reference.
+    if (_serial_forcefields) {
+        add_bonds(
+            *add_profiled_forcefield(
+                _system,
+                _profiler,
+                name,
+                md::make_bonded_pairwise_forcefield(pair_potential)
+            )
+        );
+        return;
+    }
+
+    add_bonds(
+        *add_profiled_forcefield(
+            _system,
+            _profiler,
+            name,
+            make_parallel_bonded_pairwise_forcefield(_workers, pair_potential)
+            .set_simd_level(_simd_level)
+            .set_energy_monitor(_energy_monitor, name)
+        )
+    );
+}
+
+
+void simulation_driver::setup_energy_monitor()
+{
+    // The monitor forcefield completes energy computation. So it must be the
+    // last forcefield evaluated.
+    if (_energy_monitor) {
+        _system.add_forcefield(energy_monitor_forcefield{_energy_monitor});
+    }
 }
@@ -9,8 +9,28 @@ void simulation_driver::run_simulation()
 {
     _store.set_phase("interphase");
 
+    md::step start_step = 0;
+
+    if (_resume_checkpoint) {
+        start_step = restore_checkpoint();
+        update_bead_scale();
+    }
+
+    // Time is accumulated by the integrator if the timestep is adaptive.
+    _dynamics_stats = {};
+    _dynamics_stats.time = _context.time;
+
+    auto const needs_energy = [=](md::step step) {
+        return
+            step % _config.interphase_logging_interval == 0 ||
+            step % _config.interphase_sampling_interval == 0;
+    };
+
     auto callback = [=](md::step step) {
-        _context.time = step * _config.interphase_timestep;
+        _context.time =
+            _config.interphase_spacestep > 0
+            ? _dynamics_stats.time
+            : step * _config.interphase_timestep;
 
         // Calculating energy is expensive. So update stats only when needed.
         auto const with_logging = step % _config.interphase_logging_interval == 0;
@@ -18,7 +38,8 @@ void simulation_driver::run_simulation()
         auto const sample_frame = step / _config.interphase_sampling_interval;
 
         if (with_logging || with_sampling) {
-            _context.mean_energy = _system.compute_energy() / _system.particle_count();
+            profiler_scope scope{_profiler.get(), "energy"};
+            _context.mean_energy = compute_mean_energy();
         }
 
         if (with_logging) {
@@ -26,31 +47,71 @@ void simulation_driver::run_simulation()
         }
 
         if (with_sampling) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_positions(step, _system.view_positions());
             _store.save_context(step, _context);
         }
 
-        if (step % _config.contactmap_update_interval == 0) {
-            _contact_map.update(_system.view_positions());
+        // Contact maps and profiles are both optional (thinning rate 0).
+        auto const map_rate = _config.contactmap_thinning_rate;
+        auto const profile_rate = _config.contactprofile_thinning_rate;
+        auto const profile = profile_rate > 0 ? &_contact_profile : nullptr;
+
+        if ((map_rate > 0 || profile) && step % _config.contactmap_update_interval == 0) {
+            profiler_scope scope{_profiler.get(), "contact_map"};
+
+            if (_config.contactmap_search == "shared") {
+                // Particles have moved since the last force evaluation. This
+                // is a cheap displacement check unless the list is stale.
+                _repulsion_pairs->update(_system.view_positions(), _repulsion_distance());
+                _contact_map.update(_system.view_positions(), _repulsion_pairs->pairs(), profile);
+            } else {
+                _contact_map.update(_system.view_positions(), profile);
+            }
         }
 
-        if (with_sampling && sample_frame % _config.contactmap_thinning_rate == 0) {
+        if (with_sampling && map_rate > 0 && sample_frame % map_rate == 0) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_contacts(step, _contact_map.accumulate());
             _contact_map.clear();
         }
 
+        if (with_sampling && profile && sample_frame % profile_rate == 0) {
+            profiler_scope scope{_profiler.get(), "store"};
+            _store.save_contact_profile(step, _contact_profile.data());
+            _contact_profile.clear();
+        }
+
         update_bead_scale();
-        update_wall_semiaxes();
+
+        // The adaptive timestep is known only after the first integration
+        // step, so the wall skips step 0 there. Fixed-timestep runs keep the
+        // wall step at step 0.
+        if (step > 0 || _config.interphase_spacestep == 0) {
+            update_wall_semiaxes();
+        }
+
+        request_energy(needs_energy(step + 1));
     };
 
-    callback(0);
+    // A resumed run has already processed the checkpointed step.
+    if (start_step == 0) {
+        callback(0);
+    } else {
+        request_energy(needs_energy(start_step + 1));
+    }
+
+    // Pair repulsions are soft, so they are evaluated on a coarser time grid
+    // than the stiff bonds and walls. Relaxation evaluates them every step.
+    for (auto& forcefield : _slow_forcefields) {
+        forcefield->set_update_interval(_config.interphase_repulsion_interval);
+    }
 
-    md::simulate_brownian_dynamics(_system, {
+    run_dynamics("interphase", start_step, {
         .temperature = _config.interphase_temperature,
         .spacestep   = _config.interphase_spacestep,
         .timestep    = _config.interphase_timestep,
         .steps       = _config.interphase_steps,
-        .seed        = _random(),
         .callback    = callback
     });
 }
@@ -63,6 +124,7 @@ void simulation_driver::update_bead_scale()
     _context.bead_scale = 1 - (1 - _config.bead_scale_init) * std::exp(-t_bead);
     _context.bond_scale = 1 - (1 - _config.bond_scale_init) * std::exp(-t_bond);
 
+    _repulsion_table.set_scale(_context.bead_scale);
     _contact_map.set_contact_distance(_config.contactmap_distance * _context.bead_scale);
 }
 
@@ -75,6 +137,12 @@ void simulation_driver::update_wall_semiaxes()
     net_force += _compute_packing_reaction();
     net_force -= _config.wall_semiaxes_spring.hadamard(semiaxes);
 
+    // The wall moves by the same timestep as the particles.
+    auto const timestep =
+        _config.interphase_spacestep > 0
+        ? _dynamics_stats.timestep
+        : _config.interphase_timestep;
+
     // Simulate ad-hoc overdamped motion of the wall.
-    semiaxes += _config.interphase_timestep * _config.wall_mobility * net_force;
+    semiaxes += timestep * _config.wall_mobility * net_force;
 }
@@ -7,9 +7,9 @@
 
 void simulation_driver::setup_particles()
 {
-    auto const particles = _store.load_particle_data();
-    auto const chromosomes = _store.load_chromosomes();
-    auto const nucleolus_ranges = _store.load_nucleolus_ranges();
+    auto const& particles = _metadata->particles;
+    auto const& chromosomes = _metadata->chromosomes;
+    auto const& nucleolus_ranges = _metadata->nucleolus_ranges;
 
     // Just copy particle data from the simulation metadata.
     _system.add_attribute(particle_data_attribute);
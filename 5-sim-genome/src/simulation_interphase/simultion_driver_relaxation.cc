@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
 #include <md.hpp>
 
@@ -7,20 +10,47 @@
 
 void simulation_driver::run_relaxation()
 {
+    // Relaxation has been done if the run is resumed from an interphase
+    // checkpoint.
+    if (_resume_checkpoint && _resume_checkpoint->phase != "relaxation") {
+        return;
+    }
+
     _store.set_phase("relaxation");
-    {
-        auto const init_positions = _store.load_positions(0);
+    _dynamics_stats = {};
+
+    md::step start_step = 0;
+
+    if (_resume_checkpoint) {
+        start_step = restore_checkpoint();
+    } else {
+        if (!_init_positions) {
+            _init_positions = std::make_shared<std::vector<md::point> const>(
+                _store.load_positions(0)
+            );
+        }
+        auto const& init_positions = *_init_positions;
         auto positions = _system.view_positions();
+        if (init_positions.size() != positions.size()) {
+            throw std::runtime_error("initial positions do not match the metadata");
+        }
         std::copy(init_positions.begin(), init_positions.end(), positions.begin());
     }
 
+    auto const needs_energy = [=](md::step step) {
+        return
+            step % _config.relaxation_logging_interval == 0 ||
+            step % _config.relaxation_sampling_interval == 0;
+    };
+
     auto callback = [=](md::step step) {
         // Calculating energy is expensive. So update stats only when needed.
         auto const with_logging = step % _config.relaxation_logging_interval == 0;
         auto const with_sampling = step % _config.relaxation_sampling_interval == 0;
 
         if (with_logging || with_sampling) {
-            _context.mean_energy = _system.compute_energy() / _system.particle_count();
+            profiler_scope scope{_profiler.get(), "energy"};
+            _context.mean_energy = compute_mean_energy();
         }
 
         if (with_logging) {
@@ -28,19 +58,26 @@ void simulation_driver::run_relaxation()
         }
 
         if (with_sampling) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_positions(step, _system.view_positions());
             _store.save_context(step, _context);
         }
+
+        request_energy(needs_energy(step + 1));
     };
 
-    callback(0);
+    // A resumed run has already processed the checkpointed step.
+    if (start_step == 0) {
+        callback(0);
+    } else {
+        request_energy(needs_energy(start_step + 1));
+    }
 
-    md::simulate_brownian_dynamics(_system, {
+    run_dynamics("relaxation", start_step, {
         .temperature = _config.relaxation_temperature,
         .spacestep   = _config.relaxation_spacestep,
         .timestep    = _config.relaxation_timestep,
         .steps       = _config.relaxation_steps,
-        .seed        = _random(),
         .callback    = callback
     });
 }
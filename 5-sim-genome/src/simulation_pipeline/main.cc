@@ -0,0 +1,140 @@
+// simulation_pipeline runs the spindle, relaxation and interphase stages of a
+// prepared trajectory in one process. The refined spindle conformation is
+// handed to the relaxation phase in memory, so it is neither quantized by the
+// position codec nor read back from the trajectory file. Frames are saved as
+// configured by the sampling intervals of each stage.
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+#include <md.hpp>
+
+#include "../simulation_common/command_line.hpp"
+#include "../simulation_common/simulation_store.hpp"
+#include "../simulation_interphase/simulation_driver.hpp"
+#include "../simulation_spindle/simulation_driver.hpp"
+
+
+namespace
+{
+    char const* const usage =
+        "usage: simulation_pipeline [-t threads] [-c checkpoint] [--resume]"
+        " [-i isa] [-p profile] [--profile-store] <trajectory>\n";
+
+    option const long_options[] = {
+        {"threads",       required_argument, nullptr, 't'},
+        {"checkpoint",    required_argument, nullptr, 'c'},
+        {"resume",        no_argument,       nullptr, 'r'},
+        {"isa",           required_argument, nullptr, 'i'},
+        {"profile",       required_argument, nullptr, 'p'},
+        {"profile-store", no_argument,       nullptr, 'P'},
+        {nullptr,         0,                 nullptr, 0  },
+    };
+
+    // Returns the profile filename of a stage: "profile.json" becomes
+    // "profile.spindle.json" so that the stages do not overwrite each other.
+    std::string stage_profile_filename(std::string const& filename, std::string const& stage)
+    {
+        auto const slash = filename.find_last_of('/');
+        auto const dot = filename.find_last_of('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            return filename + "." + stage;
+        }
+        return filename.substr(0, dot) + "." + stage + filename.substr(dot);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    driver_options options;
+
+    for (int opt; (opt = getopt_long(argc, argv, "t:c:ri:p:P", long_options, nullptr)) != -1; ) {
+        switch (opt) {
+        case 't': {
+            md::index threads;
+            if (!parse_index(optarg, threads)) {
+                std::cerr << usage;
+                return 1;
+            }
+            options.threads = threads;
+            break;
+        }
+
+        case 'c':
+            options.checkpoint_filename = optarg;
+            break;
+
+        case 'r':
+            options.resume = true;
+            break;
+
+        case 'i':
+            options.isa = optarg;
+            break;
+
+        case 'p':
+            options.profile.filename = optarg;
+            break;
+
+        case 'P':
+            options.profile.save_to_store = true;
+            break;
+
+        default:
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    if (options.checkpoint_filename.empty()) {
+        options.checkpoint_filename = std::string(argv[0]) + ".checkpoint";
+    }
+
+    try {
+        simulation_store store{argv[0]};
+
+        // A resumed run continues from the interphase checkpoint, which is
+        // written only after the spindle stage has finished.
+        if (!options.resume) {
+            // The spindle stage saves its own profile. The interphase stage
+            // saves to the given file.
+            auto spindle_profile = options.profile;
+            if (!spindle_profile.filename.empty()) {
+                spindle_profile.filename = stage_profile_filename(
+                    spindle_profile.filename, "spindle"
+                );
+            }
+
+            spindle::simulation_driver spindle_driver{store, spindle_profile, options.isa};
+            spindle_driver.set_save_refinement(false);
+            spindle_driver.run();
+
+            options.init_positions = std::make_shared<std::vector<md::point> const>(
+                spindle_driver.refined_positions()
+            );
+        }
+
+        simulation_driver interphase_driver{store, options};
+        interphase_driver.run();
+        store.sync();
+    } catch (std::exception const& err) {
+        std::cerr << "error: " << err.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
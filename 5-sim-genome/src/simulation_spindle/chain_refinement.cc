@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <md.hpp>
+#include <spline.hpp>
+
+#include "chain_refinement.hpp"
+
+
+refinement_method get_refinement_method(std::string const& name)
+{
+    if (name == "spline") {
+        return refine_chain_spline;
+    }
+    throw std::runtime_error("unknown refinement method: " + name);
+}
+
+
+std::vector<md::point> refine_chain_spline(md::array_view<md::point const> chain, md::index size)
+{
+    std::vector<md::point> fine_chain(size);
+
+    // A spline needs at least two knots.
+    if (chain.size() == 0) {
+        return fine_chain;
+    }
+    if (chain.size() == 1) {
+        std::fill(fine_chain.begin(), fine_chain.end(), chain[0]);
+        return fine_chain;
+    }
+
+    // This parameterization ensures that each sample point is the midpoint
+    // of a bin.
+    auto const n = chain.size();
+
+    std::vector<md::scalar> knots(n);
+    std::vector<md::scalar> xs(n);
+    std::vector<md::scalar> ys(n);
+    std::vector<md::scalar> zs(n);
+
+    for (md::index i = 0; i < n; i++) {
+        knots[i] = (md::scalar(i) + md::scalar(0.5)) / md::scalar(n);
+        xs[i] = chain[i].x;
+        ys[i] = chain[i].y;
+        zs[i] = chain[i].z;
+    }
+
+    cubic_spline const x_spline{knots, xs};
+    cubic_spline const y_spline{knots, ys};
+    cubic_spline const z_spline{knots, zs};
+
+    for (md::index k = 0; k < size; k++) {
+        auto const t = (md::scalar(k) + md::scalar(0.5)) / md::scalar(size);
+        fine_chain[k] = {x_spline(t), y_spline(t), z_spline(t)};
+    }
+
+    return fine_chain;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// This module defines functions to refine coarse-grained chains to the
+// resolution of the interphase simulation.
+
+#include <string>
+#include <vector>
+
+#include <md.hpp>
+
+
+// Type: refinement_method
+//
+// Function that refines a coarse chain to a chain of given number of points.
+//
+using refinement_method = std::vector<md::point>(*)(
+    md::array_view<md::point const> chain, md::index size
+);
+
+
+// Function: get_refinement_method
+//
+// Returns the refinement method of given name. Throws std::runtime_error if
+// the name is unknown.
+//
+refinement_method get_refinement_method(std::string const& name);
+
+
+// Function: refine_chain_spline
+//
+// Refines chain to given number of points using cubic spline interpolation
+// (cxx-spline) of each coordinate. Each coarse point is the midpoint of a bin
+// of the parameter interval [0, 1] and the fine points are sampled at the
+// midpoints of finer bins, as in scripts/refine.
+//
+std::vector<md::point> refine_chain_spline(md::array_view<md::point const> chain, md::index size);
@@ -1,17 +1,22 @@
+#include <algorithm>
 #include <cassert>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include <md.hpp>
 
+#include "../simulation_common/parallel_pairwise_forcefield.hpp"
 #include "../simulation_common/particle_data.hpp"
+#include "../simulation_common/profiler.hpp"
 #include "../simulation_common/simulation_config.hpp"
 #include "../simulation_common/simulation_store.hpp"
 
+#include "chain_refinement.hpp"
 #include "simulation_driver.hpp"
 
 
@@ -25,16 +30,30 @@ namespace
 }
 
 
-simulation_driver::simulation_driver(simulation_store& store)
+spindle::simulation_driver::simulation_driver(
+    simulation_store&      store,
+    profile_options const& profile,
+    std::string const&     isa
+)
     : _store{store}
     , _config{store.load_config()}
     , _random{_config.spindle_seed}
+    , _simd_level{parse_simd_level(isa)}
+    , _profile_options{profile}
 {
+    _store.set_queue_size(_config.store_queue_size);
+    _store.set_position_format(_config.position_format);
+    _store.set_position_layout(_config.position_layout);
+
+    if (_profile_options.enabled()) {
+        _profiler = std::make_shared<profiler>();
+    }
+
     setup();
 }
 
 
-void simulation_driver::setup()
+void spindle::simulation_driver::setup()
 {
     setup_chains();
     setup_particles();
@@ -42,7 +61,7 @@ void simulation_driver::setup()
 }
 
 
-void simulation_driver::setup_chains()
+void spindle::simulation_driver::setup_chains()
 {
     auto const chroms = _store.load_chromosomes();
     auto const coarse = _config.init_coarse_graining;
@@ -66,7 +85,7 @@ void simulation_driver::setup_chains()
 }
 
 
-void simulation_driver::setup_particles()
+void spindle::simulation_driver::setup_particles()
 {
     for (auto const& chain : _chains) {
         for (md::index i = chain.start; i < chain.end; i++) {
@@ -78,7 +97,7 @@ void simulation_driver::setup_particles()
 }
 
 
-void simulation_driver::setup_forcefield()
+void spindle::simulation_driver::setup_forcefield()
 {
     setup_repulsion_forcefield();
     setup_connectivity_forcefield();
@@ -87,27 +106,55 @@ void simulation_driver::setup_forcefield()
 }
 
 
-void simulation_driver::setup_repulsion_forcefield()
+void spindle::simulation_driver::setup_repulsion_forcefield()
 {
     // General repulsion for avoiding chain crossings.
 
-    _system.add_forcefield(
-        md::make_neighbor_pairwise_forcefield(
-            md::softcore_potential<2, 3> {
-                .energy   = _config.init_bead_repulsion,
-                .diameter = _config.init_bead_diameter
-            }
-        )
+    md::softcore_potential<2, 3> const potential {
+        .energy   = _config.init_bead_repulsion,
+        .diameter = _config.init_bead_diameter
+    };
+
+    if (_config.init_neighbor_skin > 0) {
+        // Verlet list reused while particles move less than half the skin.
+        _repulsion_pairs = std::make_shared<neighbor_pair_list>();
+        _repulsion_pairs->set_skin(_config.init_neighbor_skin);
+
+        add_profiled_forcefield(
+            _system,
+            _profiler,
+            "repulsion",
+            make_parallel_neighbor_pairwise_forcefield(
+                std::make_shared<worker_pool>(std::max(_config.simulation_threads, md::index(1))),
+                [=](md::index, md::index) {
+                    return potential;
+                }
+            )
+            .set_neighbor_distance(_config.init_bead_diameter)
+            .set_neighbor_list(_repulsion_pairs)
+            .set_simd_level(_simd_level)
+        );
+        return;
+    }
+
+    add_profiled_forcefield(
+        _system,
+        _profiler,
+        "repulsion",
+        md::make_neighbor_pairwise_forcefield(potential)
         .set_neighbor_distance(_config.init_bead_diameter)
     );
 }
 
 
-void simulation_driver::setup_connectivity_forcefield()
+void spindle::simulation_driver::setup_connectivity_forcefield()
 {
     // Spring bonds and bending cost.
 
-    auto bonds = _system.add_forcefield(
+    auto bonds = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "bond",
         md::make_bonded_pairwise_forcefield(
             md::semispring_potential {
                 .spring_constant      = _config.init_bond_spring,
@@ -116,7 +163,10 @@ void simulation_driver::setup_connectivity_forcefield()
         )
     );
 
-    auto bends = _system.add_forcefield(
+    auto bends = add_profiled_forcefield(
+        _system,
+        _profiler,
+        "bend",
         md::make_bonded_triplewise_forcefield(
             md::cosine_bending_potential {
                 .bending_energy = _config.init_bend_energy
@@ -131,7 +181,7 @@ void simulation_driver::setup_connectivity_forcefield()
 }
 
 
-void simulation_driver::setup_spindle_forcefield()
+void spindle::simulation_driver::setup_spindle_forcefield()
 {
     // Spindle core attracts centromeres.
 
@@ -156,7 +206,7 @@ void simulation_driver::setup_spindle_forcefield()
 }
 
 
-void simulation_driver::setup_packing_forcefield()
+void spindle::simulation_driver::setup_packing_forcefield()
 {
     // Weak harmonic well potential prevents open diffusion.
 
@@ -172,15 +222,20 @@ void simulation_driver::setup_packing_forcefield()
 }
 
 
-void simulation_driver::run()
+void spindle::simulation_driver::run()
 {
-    run_initialization();
-    run_spindle_phase();
-    run_packing_phase();
+    {
+        profiler_scope scope{_profiler.get(), "run"};
+        run_initialization();
+        run_spindle_phase();
+        run_packing_phase();
+        run_refinement();
+    }
+    save_profile();
 }
 
 
-void simulation_driver::run_initialization()
+void spindle::simulation_driver::run_initialization()
 {
     // Initialize chains as randomly-directed rods.
     auto positions = _system.view_positions();
@@ -204,15 +259,16 @@ void simulation_driver::run_initialization()
 }
 
 
-void simulation_driver::run_spindle_phase()
+void spindle::simulation_driver::run_spindle_phase()
 {
     _store.set_phase("spindle");
     save_chains();
 
-    _system.add_forcefield(_spindle_forcefield);
+    add_profiled_forcefield(_system, _profiler, "spindle", _spindle_forcefield);
 
     auto const callback = [&](md::step step) {
         if (step % _config.init_sampling_interval == 0) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_positions(step, _system.view_positions());
         }
 
@@ -234,15 +290,16 @@ void simulation_driver::run_spindle_phase()
 }
 
 
-void simulation_driver::run_packing_phase()
+void spindle::simulation_driver::run_packing_phase()
 {
     _store.set_phase("packing");
     save_chains();
 
-    _system.add_forcefield(_packing_forcefield);
+    add_profiled_forcefield(_system, _profiler, "packing", _packing_forcefield);
 
     auto const callback = [&](md::step step) {
         if (step % _config.init_sampling_interval == 0) {
+            profiler_scope scope{_profiler.get(), "store"};
             _store.save_positions(step, _system.view_positions());
         }
 
@@ -264,7 +321,57 @@ void simulation_driver::run_packing_phase()
 }
 
 
-void simulation_driver::print_progress(std::string const& phase, md::step step)
+void spindle::simulation_driver::run_refinement()
+{
+    // Upsample the coarse chains to the interphase resolution and save the
+    // result as the initial conformation of the relaxation phase.
+    profiler_scope scope{_profiler.get(), "refinement"};
+
+    auto const refine = get_refinement_method(_config.init_refinement_method);
+    auto const coarse = _config.init_coarse_graining;
+    auto const positions = _system.view_positions();
+
+    std::vector<md::point> fine_positions(_store.load_particle_data().size());
+
+    for (auto const& chain : _chains) {
+        auto const& chrom = chain.chromosome;
+        auto const chain_size = chain.end - chain.start;
+        auto const fine_chain = refine(
+            md::array_view<md::point const>{positions.data() + chain.start, chain_size},
+            chain_size * coarse
+        );
+        for (md::index i = chrom.start; i < chrom.end; i++) {
+            fine_positions[i] = fine_chain[i - chrom.start];
+        }
+    }
+
+    // Attach nucleolar particles.
+    for (auto const& bond : _store.load_nucleolus_bonds()) {
+        fine_positions[bond.nuc_index] = fine_positions[bond.nor_index];
+    }
+
+    _refined_positions = std::move(fine_positions);
+
+    if (_save_refinement) {
+        _store.set_phase("relaxation");
+        _store.save_positions(0, _refined_positions);
+    }
+}
+
+
+void spindle::simulation_driver::set_save_refinement(bool enabled)
+{
+    _save_refinement = enabled;
+}
+
+
+std::vector<md::point> const& spindle::simulation_driver::refined_positions() const
+{
+    return _refined_positions;
+}
+
+
+void spindle::simulation_driver::print_progress(std::string const& phase, md::step step)
 {
     auto const wallclock_time = std::time(nullptr);
 
@@ -275,12 +382,39 @@ void simulation_driver::print_progress(std::string const& phase, md::step step)
         << step
         << '\t'
         << "E: "
-        << _system.compute_energy() / _system.particle_count()
-        << '\n';
+        << _system.compute_energy() / _system.particle_count();
+
+    if (_repulsion_pairs) {
+        std::clog
+            << '\t'
+            << "rebuilds: "
+            << _repulsion_pairs->rebuild_count();
+    }
+
+    std::clog << '\n';
+}
+
+
+void spindle::simulation_driver::save_profile()
+{
+    if (!_profiler) {
+        return;
+    }
+
+    if (_repulsion_pairs) {
+        _profiler->set_count("repulsion_list_rebuilds", _repulsion_pairs->rebuild_count());
+    }
+
+    if (!_profile_options.filename.empty()) {
+        _profiler->save(_profile_options.filename);
+    }
+    if (_profile_options.save_to_store) {
+        _store.save_profile("spindle", _profiler->format_json());
+    }
 }
 
 
-void simulation_driver::save_chains()
+void spindle::simulation_driver::save_chains()
 {
     std::vector<chromosome_range> chroms;
 
@@ -3,53 +3,92 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
 #include <md.hpp>
 
+#include "../simulation_common/neighbor_pair_list.hpp"
 #include "../simulation_common/particle_data.hpp"
+#include "../simulation_common/profiler.hpp"
+#include "../simulation_common/simd_level.hpp"
 #include "../simulation_common/simulation_config.hpp"
 #include "../simulation_common/simulation_store.hpp"
 
 
-struct coarse_chain_range
+// The spindle driver shares its name with the interphase driver, which is
+// linked into the same executable in simulation_pipeline.
+namespace spindle
 {
-    chromosome_range chromosome;
-    md::index        start;
-    md::index        end;
-    md::index        centromere;
-};
+    struct coarse_chain_range
+    {
+        chromosome_range chromosome;
+        md::index        start;
+        md::index        end;
+        md::index        centromere;
+    };
 
 
-class simulation_driver
-{
-public:
-    explicit simulation_driver(simulation_store& store);
-    void run();
-
-private:
-    void setup();
-    void setup_chains();
-    void setup_particles();
-    void setup_forcefield();
-    void setup_repulsion_forcefield();
-    void setup_connectivity_forcefield();
-    void setup_spindle_forcefield();
-    void setup_packing_forcefield();
-
-    void run_initialization();
-    void run_spindle_phase();
-    void run_packing_phase();
-
-    void print_progress(std::string const& phase, md::step step);
-
-    void save_chains();
-
-private:
-    simulation_store&               _store;
-    simulation_config               _config;
-    md::system                      _system;
-    std::mt19937_64                 _random;
-    std::vector<coarse_chain_range> _chains;
-    std::shared_ptr<md::forcefield> _spindle_forcefield;
-    std::shared_ptr<md::forcefield> _packing_forcefield;
-};
+    class simulation_driver
+    {
+    public:
+        explicit simulation_driver(
+            simulation_store&      store,
+            profile_options const& profile = {},
+            std::string const&     isa = "sse"
+        );
+        void run();
+
+        // Function: set_save_refinement
+        //
+        // Enables or disables saving the refined positions to the relaxation
+        // phase of the store. Enabled by default.
+        //
+        void set_save_refinement(bool enabled);
+
+        // Function: refined_positions
+        //
+        // Returns the positions refined from the coarse chains at the end of
+        // run(). The positions have the resolution of the interphase simulation.
+        //
+        std::vector<md::point> const& refined_positions() const;
+
+    private:
+        void setup();
+        void setup_chains();
+        void setup_particles();
+        void setup_forcefield();
+        void setup_repulsion_forcefield();
+        void setup_connectivity_forcefield();
+        void setup_spindle_forcefield();
+        void setup_packing_forcefield();
+
+        void run_initialization();
+        void run_spindle_phase();
+        void run_packing_phase();
+        void run_refinement();
+
+        void print_progress(std::string const& phase, md::step step);
+        void save_profile();
+
+        void save_chains();
+
+    private:
+        simulation_store&               _store;
+        simulation_config               _config;
+        md::system                      _system;
+        std::mt19937_64                 _random;
+        simd_level                      _simd_level;
+        std::vector<coarse_chain_range> _chains;
+        std::shared_ptr<md::forcefield> _spindle_forcefield;
+        std::shared_ptr<md::forcefield> _packing_forcefield;
+        std::vector<md::point>          _refined_positions;
+        bool                            _save_refinement = true;
+
+        // Verlet list of the repulsion forcefield, if enabled.
+        std::shared_ptr<neighbor_pair_list> _repulsion_pairs;
+
+        // Non-null if profiling is enabled.
+        profile_options           _profile_options;
+        std::shared_ptr<profiler> _profiler;
+    };
+}